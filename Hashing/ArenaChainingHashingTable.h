@@ -0,0 +1,228 @@
+#ifndef ARENA_CHAINING_HASHING_TABLE_H
+#define ARENA_CHAINING_HASHING_TABLE_H
+
+#include <vector>
+#include <functional>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <algorithm>
+#include "HashUtils.h"
+
+// Separate chaining with singly linked nodes that cache their hash value.
+// Nodes are carved from slabs owned by the table and recycled through a
+// free list, so inserts rarely allocate and emptying the table releases
+// whole slabs instead of individual nodes.
+template <typename HashedObj, typename SizePolicy = PrimeSizing>
+class ArenaHashTable
+{
+public:
+    explicit ArenaHashTable(int size = 101)
+        : currentSize{0}, freeNodes{nullptr}, slabUsed{SLAB_NODES}
+    {
+        buckets.assign(sizer.resize(size), nullptr);
+    }
+
+    ArenaHashTable(const ArenaHashTable &rhs)
+        : currentSize{0}, freeNodes{nullptr}, slabUsed{SLAB_NODES}
+    {
+        buckets.assign(sizer.resize(rhs.buckets.size()), nullptr);
+        for (Node *head : rhs.buckets)
+            for (Node *p = head; p; p = p->next)
+                insert(p->element);
+    }
+
+    ArenaHashTable(ArenaHashTable &&rhs)
+        : sizer{rhs.sizer}, buckets{std::move(rhs.buckets)}, slabs{std::move(rhs.slabs)},
+          currentSize{rhs.currentSize}, freeNodes{rhs.freeNodes}, slabUsed{rhs.slabUsed}
+    {
+        rhs.buckets.assign(rhs.sizer.resize(1), nullptr);
+        rhs.currentSize = 0;
+        rhs.freeNodes = nullptr;
+        rhs.slabUsed = SLAB_NODES;
+    }
+
+    ArenaHashTable &operator=(const ArenaHashTable &rhs)
+    {
+        ArenaHashTable copy{rhs};
+        std::swap(*this, copy);
+        return *this;
+    }
+
+    ArenaHashTable &operator=(ArenaHashTable &&rhs)
+    {
+        std::swap(sizer, rhs.sizer);
+        std::swap(buckets, rhs.buckets);
+        std::swap(slabs, rhs.slabs);
+        std::swap(currentSize, rhs.currentSize);
+        std::swap(freeNodes, rhs.freeNodes);
+        std::swap(slabUsed, rhs.slabUsed);
+        return *this;
+    }
+
+    ~ArenaHashTable()
+    {
+        destroyElements();
+        releaseSlabs();
+    }
+
+    bool contains(const HashedObj &x) const
+    {
+        size_t hashVal = hashOf(x);
+        return findNode(x, hashVal, buckets[sizer.index(hashVal)]) != nullptr;
+    }
+
+    void makeEmpty()
+    {
+        destroyElements();
+        releaseSlabs();
+        std::fill(buckets.begin(), buckets.end(), nullptr);
+        currentSize = 0;
+    }
+
+    bool insert(const HashedObj &x)
+    {
+        size_t hashVal = hashOf(x);
+        Node *&head = buckets[sizer.index(hashVal)];
+        if (findNode(x, hashVal, head))
+            return false;
+
+        head = new (allocateNode()) Node{x, hashVal, head};
+        if (++currentSize > buckets.size())
+            rehash();
+        return true;
+    }
+
+    bool insert(HashedObj &&x)
+    {
+        size_t hashVal = hashOf(x);
+        Node *&head = buckets[sizer.index(hashVal)];
+        if (findNode(x, hashVal, head))
+            return false;
+
+        head = new (allocateNode()) Node{std::move(x), hashVal, head};
+        if (++currentSize > buckets.size())
+            rehash();
+        return true;
+    }
+
+    bool remove(const HashedObj &x)
+    {
+        size_t hashVal = hashOf(x);
+        for (Node **link = &buckets[sizer.index(hashVal)]; *link; link = &(*link)->next)
+        {
+            Node *p = *link;
+            if (p->hashVal == hashVal && p->element == x)
+            {
+                *link = p->next;
+                p->~Node();
+                freeNodes = new (p) FreeNode{freeNodes};
+                --currentSize;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int size() const
+    {
+        return currentSize;
+    }
+
+private:
+    struct Node
+    {
+        HashedObj element;
+        size_t hashVal;
+        Node *next;
+
+        Node(const HashedObj &e, size_t h, Node *n)
+            : element{e}, hashVal{h}, next{n} {}
+
+        Node(HashedObj &&e, size_t h, Node *n)
+            : element{std::move(e)}, hashVal{h}, next{n} {}
+    };
+
+    // What a recycled node's storage holds once its Node is destroyed.
+    struct FreeNode
+    {
+        FreeNode *next;
+    };
+
+    static const int SLAB_NODES = sizeof(Node) < 256 ? 16384 / sizeof(Node) : 64;
+
+    SizePolicy sizer;
+    std::vector<Node *> buckets;
+    std::vector<void *> slabs;
+    int currentSize;
+    FreeNode *freeNodes;
+    int slabUsed;
+
+    static size_t hashOf(const HashedObj &x)
+    {
+        return DefaultHash{}(x);
+    }
+
+    static Node *findNode(const HashedObj &x, size_t hashVal, Node *p)
+    {
+        for (; p; p = p->next)
+            if (p->hashVal == hashVal && p->element == x)
+                return p;
+        return nullptr;
+    }
+
+    void *allocateNode()
+    {
+        if (freeNodes)
+        {
+            FreeNode *p = freeNodes;
+            freeNodes = p->next;
+            p->~FreeNode();
+            return p;
+        }
+        if (slabUsed == SLAB_NODES)
+        {
+            slabs.push_back(::operator new(SLAB_NODES * sizeof(Node)));
+            slabUsed = 0;
+        }
+        return static_cast<Node *>(slabs.back()) + slabUsed++;
+    }
+
+    void destroyElements()
+    {
+        if (std::is_trivially_destructible<HashedObj>::value)
+            return;
+        for (Node *head : buckets)
+            for (Node *p = head, *next; p; p = next)
+            {
+                next = p->next;
+                p->~Node();
+            }
+    }
+
+    void releaseSlabs()
+    {
+        for (void *slab : slabs)
+            ::operator delete(slab);
+        slabs.clear();
+        freeNodes = nullptr;
+        slabUsed = SLAB_NODES;
+    }
+
+    void rehash()
+    {
+        std::vector<Node *> oldBuckets(sizer.resize(buckets.size() * 2), nullptr);
+        std::swap(buckets, oldBuckets);
+
+        for (Node *head : oldBuckets)
+            for (Node *p = head, *next; p; p = next)
+            {
+                next = p->next;
+                Node *&newHead = buckets[sizer.index(p->hashVal)];
+                p->next = newHead;
+                newHead = p;
+            }
+    }
+};
+
+#endif
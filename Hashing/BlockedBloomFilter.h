@@ -0,0 +1,96 @@
+#ifndef BLOCKED_BLOOM_FILTER_H
+#define BLOCKED_BLOOM_FILTER_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <vector>
+#include "HashUtils.h"
+
+// Bloom filter whose bits for a key all fall in one 512-bit block, so a
+// lookup reads a single cache line (Putze et al., "Cache-, Hash- and
+// Space-Efficient Bloom Filters"). Keys cannot be removed. Uses function 0
+// of HashFamily, as CuckooFilter does, for comparison with it.
+template <typename AnyType, typename HashFamily>
+class BlockedBloomFilter
+{
+public:
+    // Sizes the filter for capacity keys at roughly the requested false
+    // positive rate. Confining each key to one block costs some accuracy,
+    // which the extra BLOCK_OVERHEAD bits make up for at rates near 1%;
+    // much lower rates come out somewhat above the request.
+    explicit BlockedBloomFilter(int capacity, double falsePositiveRate = 0.01) : currentSize{0}
+    {
+        double bitsPerKey = -std::log(falsePositiveRate) / (std::log(2.0) * std::log(2.0)) * BLOCK_OVERHEAD;
+        numProbes = std::min(std::max(static_cast<int>(std::lround(bitsPerKey * std::log(2.0) / BLOCK_OVERHEAD)), 1), 16);
+        size_t bits = static_cast<size_t>(std::max(capacity, 1) * bitsPerKey);
+        blocks.resize(std::max<size_t>((bits + BLOCK_BITS - 1) / BLOCK_BITS, 1));
+    }
+
+    void insert(const AnyType &x)
+    {
+        uint64_t h = mixHash(hashFunctions.hash(x, 0));
+        Block &block = blocks[blockOf(h)];
+        uint64_t step = stepOf(h);
+        for (int i = 0; i < numProbes; ++i, h += step)
+            block.words[(h >> 6) & 7] |= UINT64_C(1) << (h & 63);
+        ++currentSize;
+    }
+
+    bool contains(const AnyType &x) const
+    {
+        uint64_t h = mixHash(hashFunctions.hash(x, 0));
+        const Block &block = blocks[blockOf(h)];
+        uint64_t step = stepOf(h);
+        for (int i = 0; i < numProbes; ++i, h += step)
+            if (!(block.words[(h >> 6) & 7] & UINT64_C(1) << (h & 63)))
+                return false;
+        return true;
+    }
+
+    void makeEmpty()
+    {
+        std::fill(blocks.begin(), blocks.end(), Block{});
+        currentSize = 0;
+    }
+
+    // Number of insert calls, counting repeated keys again.
+    int size() const
+    {
+        return currentSize;
+    }
+
+    double bitsPerKey() const
+    {
+        return currentSize == 0 ? 0 : static_cast<double>(blocks.size()) * BLOCK_BITS / currentSize;
+    }
+
+private:
+    enum {BLOCK_BITS = 512};
+    static constexpr double BLOCK_OVERHEAD = 1.2;
+
+    struct alignas(64) Block
+    {
+        uint64_t words[BLOCK_BITS / 64] = {};
+    };
+
+    std::vector<Block> blocks;
+    int numProbes;
+    int currentSize;
+    HashFamily hashFunctions;
+
+    // The block comes from the high half of the hash; the bit positions
+    // from the low half stepped by an odd increment (double hashing).
+    size_t blockOf(uint64_t h) const
+    {
+        return ((h >> 32) * blocks.size()) >> 32;
+    }
+
+    static uint64_t stepOf(uint64_t h)
+    {
+        return (mixHash(h) >> 23) | 1;
+    }
+};
+
+#endif
@@ -0,0 +1,212 @@
+#ifndef BUCKETIZED_CUCKOO_HASH_TABLE_H
+#define BUCKETIZED_CUCKOO_HASH_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <vector>
+#include "CuckooHashTable.h"
+
+// The slots of a tag and an element that fit in one cache line, but at
+// least four.
+template <typename AnyType>
+constexpr int lineSlots()
+{
+    return std::max(64 / static_cast<int>(1 + sizeof(AnyType)), 4);
+}
+
+// Cuckoo hashing where each hash function selects a bucket of Slots
+// entries instead of a single cell. Every slot carries an 8-bit fingerprint
+// of its element (0 marks an empty slot), so a lookup compares fingerprints
+// in at most one bucket per hash function and touches an element only on a
+// match. With four or more slots per bucket the table stays insertable
+// beyond 90% load.
+//
+// Buckets are cache-line aligned, and by default hold as many slots as
+// fit in one line (but at least four), so a lookup touches one line per
+// hash function.
+template <typename AnyType, typename HashFamily, int Slots = lineSlots<AnyType>()>
+class BucketizedCuckooHashTable
+{
+public:
+    explicit BucketizedCuckooHashTable(int size = 101)
+    {
+        buckets.resize(sizer.resize(std::max(static_cast<int>(size / MAX_BUCKET_LOAD) / Slots, 1)));
+        numHashFunctions = hashFunctions.getNumberOfFunctions();
+        rehashes = 0;
+        makeEmpty();
+    }
+
+    bool contains(const AnyType &x) const
+    {
+        int slot;
+        return findPos(x, slot) != -1;
+    }
+
+    void makeEmpty()
+    {
+        currentSize = 0;
+        for (auto &bucket : buckets)
+            std::fill(bucket.tags, bucket.tags + Slots, 0);
+    }
+
+    bool insert(const AnyType &x)
+    {
+        if (contains(x))
+            return false;
+
+        if (currentSize >= capacity() * MAX_BUCKET_LOAD)
+            expand();
+
+        AnyType copy = x;
+        insertHelper(std::move(copy));
+        return true;
+    }
+
+    bool insert(AnyType &&x)
+    {
+        if (contains(x))
+            return false;
+
+        if (currentSize >= capacity() * MAX_BUCKET_LOAD)
+            expand();
+
+        insertHelper(std::move(x));
+        return true;
+    }
+
+    bool remove(const AnyType &x)
+    {
+        int slot;
+        int pos = findPos(x, slot);
+        if (pos == -1)
+            return false;
+
+        buckets[pos].tags[slot] = 0;
+        --currentSize;
+        return true;
+    }
+
+    int size() const
+    {
+        return currentSize;
+    }
+
+    int capacity() const
+    {
+        return buckets.size() * Slots;
+    }
+
+private:
+    // C++17 allocators honour the over-alignment, so every bucket in the
+    // vector starts on a line of its own.
+    struct alignas(64) Bucket
+    {
+        uint8_t tags[Slots];
+        AnyType elements[Slots];
+    };
+
+    static constexpr double MAX_BUCKET_LOAD = 0.95;
+    static const int ALLOWED_REHASHES = 5;
+
+    PowerOfTwoSizing sizer;
+    std::vector<Bucket> buckets;
+    int currentSize;
+    int numHashFunctions;
+    int rehashes;
+    UniformRandom r;
+    HashFamily hashFunctions;
+
+    static uint8_t tagOf(size_t hashVal)
+    {
+        uint8_t tag = mixHash(hashVal) >> 56;
+        return tag ? tag : 1;
+    }
+
+    int myhash(const AnyType &x, int which) const
+    {
+        return sizer.index(hashFunctions.hash(x, which));
+    }
+
+    int findPos(const AnyType &x, int &slot) const
+    {
+        uint8_t tag = tagOf(hashFunctions.hash(x, 0));
+        for (int i = 0; i < numHashFunctions; ++i)
+        {
+            int pos = myhash(x, i);
+            const Bucket &bucket = buckets[pos];
+            for (slot = 0; slot < Slots; ++slot)
+                if (bucket.tags[slot] == tag && bucket.elements[slot] == x)
+                    return pos;
+        }
+        return -1;
+    }
+
+    bool placeInBucket(int pos, AnyType &x, uint8_t tag)
+    {
+        Bucket &bucket = buckets[pos];
+        for (int slot = 0; slot < Slots; ++slot)
+            if (bucket.tags[slot] == 0)
+            {
+                bucket.elements[slot] = std::move(x);
+                bucket.tags[slot] = tag;
+                ++currentSize;
+                return true;
+            }
+        return false;
+    }
+
+    void insertHelper(AnyType &&x)
+    {
+        const int COUNT_LIMIT = 500;
+
+        while (true)
+        {
+            for (int count = 0; count < COUNT_LIMIT; ++count)
+            {
+                uint8_t tag = tagOf(hashFunctions.hash(x, 0));
+                for (int i = 0; i < numHashFunctions; ++i)
+                    if (placeInBucket(myhash(x, i), x, tag))
+                        return;
+
+                Bucket &bucket = buckets[myhash(x, r.next(numHashFunctions))];
+                int slot = r.next(Slots);
+                std::swap(x, bucket.elements[slot]);
+                bucket.tags[slot] = tag;
+            }
+
+            if (++rehashes > ALLOWED_REHASHES)
+            {
+                expand();
+                rehashes = 0;
+            }
+            else
+                rehash();
+        }
+    }
+
+    void expand()
+    {
+        rehash(buckets.size() * 2);
+    }
+
+    void rehash()
+    {
+        hashFunctions.generateNewFunctions();
+        rehash(buckets.size());
+    }
+
+    void rehash(int newBuckets)
+    {
+        std::vector<Bucket> oldBuckets = std::move(buckets);
+
+        buckets.resize(sizer.resize(newBuckets));
+        makeEmpty();
+        for (auto &bucket : oldBuckets)
+            for (int slot = 0; slot < Slots; ++slot)
+                if (bucket.tags[slot] != 0)
+                    insertHelper(std::move(bucket.elements[slot]));
+    }
+};
+
+#endif
@@ -0,0 +1,382 @@
+#ifndef CONCURRENT_CUCKOO_HASH_TABLE_H
+#define CONCURRENT_CUCKOO_HASH_TABLE_H
+
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <random>
+#include <type_traits>
+#include <algorithm>
+#include "HashUtils.h"
+
+// Concurrent cuckoo hashing in the style of libcuckoo. Every key lives in
+// one of two buckets of SLOTS entries. Writers lock the version counters of
+// the lock stripes covering the buckets they touch; readers take no locks
+// and retry if either counter was odd or changed while they read. Inserts
+// that find both buckets full search breadth-first for a short cuckoo path
+// and then displace it one step at a time, locking only the two buckets of
+// each step.
+//
+// Keys are stored in std::atomic slots, so AnyType must be trivially
+// copyable. HashFamily must provide at least two functions and is never
+// regenerated; a table that cannot place a key doubles instead. Replaced
+// bucket arrays are kept until destruction because readers may still be
+// scanning them.
+template <typename AnyType, typename HashFamily>
+class ConcurrentCuckooHashTable
+{
+    static_assert(std::is_trivially_copyable<AnyType>::value,
+                  "ConcurrentCuckooHashTable requires trivially copyable keys");
+
+public:
+    explicit ConcurrentCuckooHashTable(int size = 101) : currentSize{0}
+    {
+        PowerOfTwoSizing sizer;
+        tables.emplace_back(new BucketArray(sizer.resize(std::max(size / SLOTS, 1))));
+        table.store(tables.back().get());
+    }
+
+    ConcurrentCuckooHashTable(const ConcurrentCuckooHashTable &) = delete;
+    ConcurrentCuckooHashTable &operator=(const ConcurrentCuckooHashTable &) = delete;
+
+    bool contains(const AnyType &x) const
+    {
+        size_t h0 = hashFunctions.hash(x, 0);
+        size_t h1 = hashFunctions.hash(x, 1);
+
+        while (true)
+        {
+            const BucketArray *t = table.load(std::memory_order_acquire);
+            size_t b0 = t->index(h0), b1 = t->index(h1);
+            unsigned v0 = locks[stripe(b0)].version.load(std::memory_order_acquire);
+            unsigned v1 = locks[stripe(b1)].version.load(std::memory_order_acquire);
+            if ((v0 | v1) & 1)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            bool found = findSlot(t->buckets[b0], x) != -1 || findSlot(t->buckets[b1], x) != -1;
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (locks[stripe(b0)].version.load(std::memory_order_relaxed) == v0
+                && locks[stripe(b1)].version.load(std::memory_order_relaxed) == v1
+                && table.load(std::memory_order_relaxed) == t)
+                return found;
+        }
+    }
+
+    bool insert(const AnyType &x)
+    {
+        size_t h0 = hashFunctions.hash(x, 0);
+        size_t h1 = hashFunctions.hash(x, 1);
+
+        while (true)
+        {
+            BucketArray *t = table.load(std::memory_order_acquire);
+            size_t b0 = t->index(h0), b1 = t->index(h1);
+            LockPair guard{*this, b0, b1};
+            if (table.load(std::memory_order_relaxed) != t)
+                continue;
+
+            if (findSlot(t->buckets[b0], x) != -1 || findSlot(t->buckets[b1], x) != -1)
+                return false;
+
+            if (place(t->buckets[b0], x) || place(t->buckets[b1], x))
+            {
+                ++currentSize;
+                return true;
+            }
+
+            guard.unlock();
+            if (!makeRoom(t, b0, b1))
+                expand(t);
+        }
+    }
+
+    bool remove(const AnyType &x)
+    {
+        size_t h0 = hashFunctions.hash(x, 0);
+        size_t h1 = hashFunctions.hash(x, 1);
+
+        while (true)
+        {
+            BucketArray *t = table.load(std::memory_order_acquire);
+            size_t b0 = t->index(h0), b1 = t->index(h1);
+            LockPair guard{*this, b0, b1};
+            if (table.load(std::memory_order_relaxed) != t)
+                continue;
+
+            for (size_t b : {b0, b1})
+            {
+                int slot = findSlot(t->buckets[b], x);
+                if (slot != -1)
+                {
+                    t->buckets[b].occupied[slot].store(false, std::memory_order_relaxed);
+                    --currentSize;
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    int size() const
+    {
+        return currentSize.load();
+    }
+
+    int capacity() const
+    {
+        return (table.load()->mask + 1) * SLOTS;
+    }
+
+private:
+    static const int SLOTS = 4;
+    static const int LOCK_COUNT = 2048;
+    static const int MAX_BFS_DEPTH = 5;
+    static const int REHASH_COUNT_LIMIT = 500;
+
+    struct Bucket
+    {
+        std::atomic<bool> occupied[SLOTS];
+        std::atomic<AnyType> keys[SLOTS];
+    };
+
+    struct BucketArray
+    {
+        size_t mask;
+        std::unique_ptr<Bucket[]> buckets;
+
+        explicit BucketArray(size_t n) : mask{n - 1}, buckets{new Bucket[n]}
+        {
+            for (size_t i = 0; i < n; ++i)
+                for (auto &occupied : buckets[i].occupied)
+                    occupied.store(false, std::memory_order_relaxed);
+        }
+
+        size_t index(size_t hashVal) const
+        {
+            return mixHash(hashVal) & mask;
+        }
+    };
+
+    struct alignas(64) Lock
+    {
+        std::atomic<unsigned> version{0};
+    };
+
+    // Locks the stripes of two buckets in stripe order, once if they share one.
+    class LockPair
+    {
+    public:
+        LockPair(const ConcurrentCuckooHashTable &t, size_t b0, size_t b1)
+            : owner{t}, first{std::min(stripe(b0), stripe(b1))},
+              second{std::max(stripe(b0), stripe(b1))}, held{true}
+        {
+            owner.lock(first);
+            if (second != first)
+                owner.lock(second);
+        }
+
+        ~LockPair()
+        {
+            unlock();
+        }
+
+        void unlock()
+        {
+            if (!held)
+                return;
+            if (second != first)
+                owner.unlock(second);
+            owner.unlock(first);
+            held = false;
+        }
+
+    private:
+        const ConcurrentCuckooHashTable &owner;
+        size_t first;
+        size_t second;
+        bool held;
+    };
+
+    struct PathNode
+    {
+        size_t bucket;
+        int parent;
+        int slot;
+        int depth;
+    };
+
+    std::atomic<BucketArray *> table;
+    std::vector<std::unique_ptr<BucketArray>> tables;
+    mutable Lock locks[LOCK_COUNT];
+    std::atomic<int> currentSize;
+    HashFamily hashFunctions;
+
+    static size_t stripe(size_t bucket)
+    {
+        return bucket & (LOCK_COUNT - 1);
+    }
+
+    // The release fence orders the odd version before the relaxed slot writes
+    // that follow. It pairs with the acquire fence in contains(): a reader
+    // that sees any of those writes then re-reads the odd or a later version
+    // and retries.
+    void lock(size_t s) const
+    {
+        std::atomic<unsigned> &version = locks[s].version;
+        while (true)
+        {
+            unsigned v = version.load(std::memory_order_relaxed);
+            if (!(v & 1) && version.compare_exchange_weak(v, v + 1, std::memory_order_acquire))
+            {
+                std::atomic_thread_fence(std::memory_order_release);
+                return;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    void unlock(size_t s) const
+    {
+        locks[s].version.fetch_add(1, std::memory_order_release);
+    }
+
+    static int findSlot(const Bucket &bucket, const AnyType &x)
+    {
+        for (int i = 0; i < SLOTS; ++i)
+            if (bucket.occupied[i].load(std::memory_order_relaxed)
+                && bucket.keys[i].load(std::memory_order_relaxed) == x)
+                return i;
+        return -1;
+    }
+
+    static int freeSlot(const Bucket &bucket)
+    {
+        for (int i = 0; i < SLOTS; ++i)
+            if (!bucket.occupied[i].load(std::memory_order_relaxed))
+                return i;
+        return -1;
+    }
+
+    static bool place(Bucket &bucket, const AnyType &x)
+    {
+        int slot = freeSlot(bucket);
+        if (slot == -1)
+            return false;
+        bucket.keys[slot].store(x, std::memory_order_relaxed);
+        bucket.occupied[slot].store(true, std::memory_order_relaxed);
+        return true;
+    }
+
+    size_t alternate(const BucketArray *t, const AnyType &x, size_t bucket) const
+    {
+        size_t b0 = t->index(hashFunctions.hash(x, 0));
+        return b0 != bucket ? b0 : t->index(hashFunctions.hash(x, 1));
+    }
+
+    // Frees a slot in b0 or b1 by finding a cuckoo path without locks and then
+    // moving its keys from the far end back. Returns false when no path
+    // exists; a path invalidated by another writer counts as success so the
+    // caller simply retries.
+    bool makeRoom(BucketArray *t, size_t b0, size_t b1)
+    {
+        std::vector<PathNode> nodes{{b0, -1, -1, 0}, {b1, -1, -1, 0}};
+
+        for (size_t head = 0; head < nodes.size(); ++head)
+        {
+            PathNode node = nodes[head];
+            if (freeSlot(t->buckets[node.bucket]) != -1)
+                return movePath(t, nodes, head);
+            if (node.depth == MAX_BFS_DEPTH)
+                continue;
+
+            for (int slot = 0; slot < SLOTS; ++slot)
+            {
+                AnyType key = t->buckets[node.bucket].keys[slot].load(std::memory_order_relaxed);
+                size_t alt = alternate(t, key, node.bucket);
+                nodes.push_back({alt, static_cast<int>(head), slot, node.depth + 1});
+            }
+        }
+        return false;
+    }
+
+    bool movePath(BucketArray *t, const std::vector<PathNode> &nodes, int last)
+    {
+        for (int i = last; nodes[i].parent != -1; i = nodes[i].parent)
+        {
+            size_t from = nodes[nodes[i].parent].bucket;
+            size_t to = nodes[i].bucket;
+            int slot = nodes[i].slot;
+
+            LockPair guard{*this, from, to};
+            if (table.load(std::memory_order_relaxed) != t)
+                return true;
+
+            Bucket &src = t->buckets[from];
+            if (!src.occupied[slot].load(std::memory_order_relaxed))
+                continue;
+            AnyType key = src.keys[slot].load(std::memory_order_relaxed);
+            if (alternate(t, key, from) != to || !place(t->buckets[to], key))
+                return true;
+            src.occupied[slot].store(false, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    void expand(BucketArray *t)
+    {
+        for (size_t s = 0; s < LOCK_COUNT; ++s)
+            lock(s);
+
+        if (table.load(std::memory_order_relaxed) == t)
+        {
+            size_t n = (t->mask + 1) * 2;
+            std::unique_ptr<BucketArray> bigger{new BucketArray(n)};
+            while (!rehashInto(*t, *bigger))
+                bigger.reset(new BucketArray(n *= 2));
+            tables.push_back(std::move(bigger));
+            table.store(tables.back().get(), std::memory_order_release);
+        }
+
+        for (size_t s = LOCK_COUNT; s-- > 0; )
+            unlock(s);
+    }
+
+    // Moves every key of src into dst with single-threaded random-walk
+    // cuckoo insertion; every stripe is locked by the caller.
+    bool rehashInto(const BucketArray &src, BucketArray &dst) const
+    {
+        std::default_random_engine generator;
+        std::uniform_int_distribution<int> pick(0, SLOTS - 1);
+
+        for (size_t b = 0; b <= src.mask; ++b)
+            for (int i = 0; i < SLOTS; ++i)
+            {
+                if (!src.buckets[b].occupied[i].load(std::memory_order_relaxed))
+                    continue;
+                AnyType x = src.buckets[b].keys[i].load(std::memory_order_relaxed);
+                size_t pos = dst.index(hashFunctions.hash(x, 0));
+
+                for (int count = 0; ; ++count)
+                {
+                    size_t alt = alternate(&dst, x, pos);
+                    if (place(dst.buckets[pos], x) || place(dst.buckets[alt], x))
+                        break;
+                    if (count == REHASH_COUNT_LIMIT)
+                        return false;
+
+                    std::atomic<AnyType> &victim = dst.buckets[alt].keys[pick(generator)];
+                    x = victim.exchange(x, std::memory_order_relaxed);
+                    pos = alt;
+                }
+            }
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef CONCURRENT_HASH_TABLE_H
+#define CONCURRENT_HASH_TABLE_H
+
+#include <vector>
+#include <functional>
+#include <cstddef>
+#include <algorithm>
+#include <mutex>
+#include <shared_mutex>
+#include "HashUtils.h"
+
+// Splits keys across Shards independent tables by the high bits of their
+// mixed hash. Each shard has its own reader/writer lock, so lookups only
+// contend with writers to the same shard. Table is any of the HashTable
+// templates in this directory instantiated for HashedObj; the shard tables
+// keep using the low bits of the hash for their own indexing.
+template <typename HashedObj, typename Table, int Shards = 16>
+class ConcurrentHashTable
+{
+public:
+    explicit ConcurrentHashTable(int size = 101) : shards(Shards)
+    {
+        for (auto &shard : shards)
+            shard.table = Table{std::max(size / Shards, 1)};
+    }
+
+    bool contains(const HashedObj &x) const
+    {
+        const Shard &shard = shardOf(x);
+        std::shared_lock<std::shared_mutex> guard{shard.lock};
+        return shard.table.contains(x);
+    }
+
+    void makeEmpty()
+    {
+        for (auto &shard : shards)
+        {
+            std::lock_guard<std::shared_mutex> guard{shard.lock};
+            shard.table.makeEmpty();
+        }
+    }
+
+    bool insert(const HashedObj &x)
+    {
+        Shard &shard = shardOf(x);
+        std::lock_guard<std::shared_mutex> guard{shard.lock};
+        return shard.table.insert(x);
+    }
+
+    bool insert(HashedObj &&x)
+    {
+        Shard &shard = shardOf(x);
+        std::lock_guard<std::shared_mutex> guard{shard.lock};
+        return shard.table.insert(std::move(x));
+    }
+
+    bool remove(const HashedObj &x)
+    {
+        Shard &shard = shardOf(x);
+        std::lock_guard<std::shared_mutex> guard{shard.lock};
+        return shard.table.remove(x);
+    }
+
+    // Shards are counted one at a time, so the result is only exact when
+    // no writer runs concurrently.
+    int size() const
+    {
+        int total = 0;
+        for (auto &shard : shards)
+        {
+            std::shared_lock<std::shared_mutex> guard{shard.lock};
+            total += shard.table.size();
+        }
+        return total;
+    }
+
+private:
+    struct alignas(64) Shard
+    {
+        mutable std::shared_mutex lock;
+        Table table;
+    };
+
+    std::vector<Shard> shards;
+
+    // Hashes with DefaultHash like the shard tables, so keys of every type
+    // are hashed by the same function at both levels.
+    static size_t shardIndex(const HashedObj &x)
+    {
+        return ((mixHash(DefaultHash{}(x)) >> 32) * Shards) >> 32;
+    }
+
+    Shard &shardOf(const HashedObj &x)
+    {
+        return shards[shardIndex(x)];
+    }
+
+    const Shard &shardOf(const HashedObj &x) const
+    {
+        return shards[shardIndex(x)];
+    }
+};
+
+#endif
@@ -0,0 +1,217 @@
+#ifndef CUCKOO_FILTER_H
+#define CUCKOO_FILTER_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "HashUtils.h"
+
+// Approximate set membership by partial-key cuckoo hashing (Fan et al.,
+// "Cuckoo Filter: Practically Better Than Bloom"). Only a small nonzero
+// fingerprint of each key is kept, bit-packed, in one of two buckets of
+// Slots entries; the second bucket is a hash of the fingerprint minus the
+// first (mod the bucket count), so an entry can be moved without knowing
+// its key, and the bucket count need not be a power of two. contains
+// never misses an inserted key and reports an absent one with probability
+// about 2 * Slots / 2^bits. remove must only be given keys that were
+// inserted.
+//
+// HashFamily is the cuckoo table's hash family interface; only function 0
+// is used, and it is never regenerated because the keys are not stored.
+template <typename AnyType, typename HashFamily, int Slots = 4>
+class CuckooFilter
+{
+public:
+    // Sizes the filter for capacity keys with fingerprints just wide enough
+    // for the requested false positive rate.
+    explicit CuckooFilter(int capacity, double falsePositiveRate = 0.01) : currentSize{0}
+    {
+        double bits = std::ceil(std::log2(2.0 * Slots / falsePositiveRate));
+        tagBits = std::min(std::max(static_cast<int>(bits), 4), 32);
+        tagMask = tagBits == 32 ? 0xFFFFFFFF : (UINT32_C(1) << tagBits) - 1;
+
+        buckets = std::max(static_cast<size_t>(std::ceil(capacity / MAX_BUCKET_LOAD / Slots)), size_t{1});
+        tags.assign((buckets * Slots * tagBits + 63) / 64 + 1, 0);
+        victim.used = false;
+    }
+
+    // Returns false when the filter is full; the key is then not added.
+    bool insert(const AnyType &x)
+    {
+        if (victim.used)
+            return false;
+
+        size_t pos;
+        uint32_t tag;
+        locate(x, pos, tag);
+        if (place(pos, tag) || place(alternate(pos, tag), tag))
+        {
+            ++currentSize;
+            return true;
+        }
+
+        if (generator() & 1)
+            pos = alternate(pos, tag);
+        for (int count = 0; count < MAX_KICKS; ++count)
+        {
+            size_t slot = pos * Slots + generator() % Slots;
+            uint32_t evicted = readTag(slot);
+            writeTag(slot, tag);
+            tag = evicted;
+            pos = alternate(pos, tag);
+            if (place(pos, tag))
+            {
+                ++currentSize;
+                return true;
+            }
+        }
+
+        // The last evicted fingerprint has nowhere to go; keeping it aside
+        // preserves the no-false-negative guarantee.
+        victim = {pos, tag, true};
+        ++currentSize;
+        return true;
+    }
+
+    bool contains(const AnyType &x) const
+    {
+        size_t pos;
+        uint32_t tag;
+        locate(x, pos, tag);
+        size_t alt = alternate(pos, tag);
+        if (findTag(pos, tag) != -1 || findTag(alt, tag) != -1)
+            return true;
+        return victim.used && victim.tag == tag && (victim.pos == pos || victim.pos == alt);
+    }
+
+    bool remove(const AnyType &x)
+    {
+        size_t pos;
+        uint32_t tag;
+        locate(x, pos, tag);
+        size_t alt = alternate(pos, tag);
+
+        if (victim.used && victim.tag == tag && (victim.pos == pos || victim.pos == alt))
+            victim.used = false;
+        else if (!eraseTag(pos, tag) && !eraseTag(alt, tag))
+            return false;
+        --currentSize;
+
+        if (victim.used && (place(victim.pos, victim.tag) || place(alternate(victim.pos, victim.tag), victim.tag)))
+            victim.used = false;
+        return true;
+    }
+
+    int size() const
+    {
+        return currentSize;
+    }
+
+    int capacity() const
+    {
+        return buckets * Slots;
+    }
+
+    int fingerprintBits() const
+    {
+        return tagBits;
+    }
+
+    double bitsPerKey() const
+    {
+        return currentSize == 0 ? 0 : 64.0 * tags.size() / currentSize;
+    }
+
+private:
+    struct Victim
+    {
+        size_t pos;
+        uint32_t tag;
+        bool used;
+    };
+
+    static constexpr double MAX_BUCKET_LOAD = 0.95;
+    static const int MAX_KICKS = 500;
+
+    std::vector<uint64_t> tags;
+    size_t buckets;
+    int tagBits;
+    uint32_t tagMask;
+    int currentSize;
+    Victim victim;
+    HashFamily hashFunctions;
+    std::minstd_rand generator;
+
+    void locate(const AnyType &x, size_t &pos, uint32_t &tag) const
+    {
+        uint64_t h = mixHash(hashFunctions.hash(x, 0));
+        pos = (static_cast<uint32_t>(h) * buckets) >> 32;
+        tag = (h >> 32) & tagMask;
+        if (tag == 0)
+            tag = 1;
+    }
+
+    // Maps each bucket of a fingerprint to the other one.
+    size_t alternate(size_t pos, uint32_t tag) const
+    {
+        size_t h = ((mixHash(tag) >> 32) * buckets) >> 32;
+        return h >= pos ? h - pos : h + buckets - pos;
+    }
+
+    // Fingerprints are tagBits wide and packed back to back; a field may
+    // straddle two words, and tags has one spare word at the end.
+    uint32_t readTag(size_t slot) const
+    {
+        size_t bit = slot * tagBits;
+        size_t word = bit / 64, shift = bit % 64;
+        uint64_t v = tags[word] >> shift;
+        if (shift + tagBits > 64)
+            v |= tags[word + 1] << (64 - shift);
+        return v & tagMask;
+    }
+
+    void writeTag(size_t slot, uint32_t tag)
+    {
+        size_t bit = slot * tagBits;
+        size_t word = bit / 64, shift = bit % 64;
+        tags[word] = (tags[word] & ~(static_cast<uint64_t>(tagMask) << shift))
+                     | static_cast<uint64_t>(tag) << shift;
+        if (shift + tagBits > 64)
+        {
+            int low = 64 - shift;
+            tags[word + 1] = (tags[word + 1] & ~(static_cast<uint64_t>(tagMask) >> low))
+                             | static_cast<uint64_t>(tag) >> low;
+        }
+    }
+
+    int findTag(size_t pos, uint32_t tag) const
+    {
+        for (int i = 0; i < Slots; ++i)
+            if (readTag(pos * Slots + i) == tag)
+                return i;
+        return -1;
+    }
+
+    bool place(size_t pos, uint32_t tag)
+    {
+        int i = findTag(pos, 0);
+        if (i == -1)
+            return false;
+        writeTag(pos * Slots + i, tag);
+        return true;
+    }
+
+    bool eraseTag(size_t pos, uint32_t tag)
+    {
+        int i = findTag(pos, tag);
+        if (i == -1)
+            return false;
+        writeTag(pos * Slots + i, 0);
+        return true;
+    }
+};
+
+#endif
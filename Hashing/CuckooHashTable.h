@@ -6,6 +6,13 @@
 #include <vector>
 #include <random>
 #include <string>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include "HashStats.h"
+#include "HashUtils.h"
+#include "MappedFile.h"
+#include "StringHash.h"
 
 class UniformRandom
 {
@@ -23,7 +30,7 @@ public:
 
     int next(int low, int high)
     {
-        static std::uniform_int_distribution<int> distribution(low, high);
+        std::uniform_int_distribution<int> distribution(low, high);
         return distribution(generator);
     }
 
@@ -44,7 +51,7 @@ template <int count>
 class StringHashFamily
 {
 public:
-    StringHashFamily() : MULTIPLIERS(count)
+    StringHashFamily() : seeds(count)
     {
         generateNewFunctions();
     }
@@ -56,36 +63,45 @@ public:
 
     void generateNewFunctions()
     {
-        for (auto &mult : MULTIPLIERS)
-            mult = r.next();
+        for (auto &seed : seeds)
+            seed = static_cast<uint64_t>(r.next()) << 32 ^ static_cast<uint32_t>(r.next());
     }
 
     size_t hash(const std::string &x, int which) const
     {
-        const int multiplier = MULTIPLIERS[which];
-        size_t hashVal = 0;
-        for (auto ch : x)
-            hashVal = multiplier * hashVal + ch;
-        return hashVal;
+        return hashBytes(x.data(), x.size(), seeds[which]);
     }
 
+    size_t hash(const char *x, int which) const
+    {
+        return hashBytes(x, std::strlen(x), seeds[which]);
+    }
+
+#if __cplusplus >= 201703L
+    size_t hash(std::string_view x, int which) const
+    {
+        return hashBytes(x.data(), x.size(), seeds[which]);
+    }
+#endif
+
 private:
-    std::vector<int> MULTIPLIERS;
+    std::vector<uint64_t> seeds;
     UniformRandom r;
 };
 
-int nextPrime(int n);
-
 #define MAX_LOAD 0.40
 
-template <typename AnyType, typename HashFamily>
+template <typename AnyType, typename HashFamily, typename SizePolicy = PrimeSizing,
+          typename StatsPolicy = NoStats>
 class HashTable
 {
 public:
-    explicit HashTable(int size = 101) : array(nextPrime(size))
+    explicit HashTable(int size = 101)
     {
+        array.resize(sizer.resize(size));
         numHashFunctions = hashFunctions.getNumberOfFunctions();
         rehashes = 0;
+        hashGeneration = 0;
         makeEmpty();
     }
 
@@ -94,6 +110,25 @@ public:
         return findPos(x) != -1;
     }
 
+    // Key must also be accepted by HashFamily::hash, with equal results.
+    template <typename Key, typename = EnableIfTransparent<AnyType, Key>>
+    bool contains(const Key &x) const
+    {
+        return findPos(x) != -1;
+    }
+
+    void containsBatch(const AnyType *keys, int n, bool *out) const
+    {
+        std::vector<size_t> hashVals(PREFETCH_BATCH * numHashFunctions);
+        for (int base = 0; base < n; base += PREFETCH_BATCH)
+        {
+            int count = std::min(PREFETCH_BATCH, n - base);
+            prefetchBatch(keys + base, count, hashVals.data());
+            for (int i = 0; i < count; ++i)
+                out[base + i] = findPos(keys[base + i], &hashVals[i * numHashFunctions]) != -1;
+        }
+    }
+
     void makeEmpty()
     {
         currentSize = 0;
@@ -123,6 +158,60 @@ public:
         return insertHelper(std::move(x));
     }
 
+    // hashVals[j] must be hash(x, j) under the current hash functions.
+    bool insert(const AnyType &x, const size_t *hashVals)
+    {
+        return insertHashed(x, hashVals);
+    }
+
+    bool insert(AnyType &&x, const size_t *hashVals)
+    {
+        return insertHashed(std::move(x), hashVals);
+    }
+
+    // The hashes kept for a batch go stale if an insert picks new hash
+    // functions, so the rest of that batch is hashed again.
+    int insertBatch(const AnyType *keys, int n)
+    {
+        std::vector<size_t> hashVals(PREFETCH_BATCH * numHashFunctions);
+        int inserted = 0;
+        for (int base = 0; base < n; base += PREFETCH_BATCH)
+        {
+            int count = std::min(PREFETCH_BATCH, n - base);
+            prefetchBatch(keys + base, count, hashVals.data());
+            int generation = hashGeneration;
+            for (int i = 0; i < count; ++i)
+                if (generation == hashGeneration)
+                    inserted += insert(keys[base + i], &hashVals[i * numHashFunctions]);
+                else
+                    inserted += insert(keys[base + i]);
+        }
+        return inserted;
+    }
+
+    // Builds a table holding [first, last), sized once for all of them.
+    // Eviction walks make placement inherently serial, so only the sizing
+    // and the prefetching of candidate slots are done up front.
+    template <typename Iterator>
+    static HashTable build(Iterator first, Iterator last)
+    {
+        std::vector<AnyType> staging(first, last);
+        HashTable table(static_cast<int>(staging.size() / MAX_LOAD) + 1);
+        std::vector<size_t> hashVals(PREFETCH_BATCH * table.numHashFunctions);
+        for (int base = 0; base < staging.size(); base += PREFETCH_BATCH)
+        {
+            int count = std::min<int>(PREFETCH_BATCH, staging.size() - base);
+            table.prefetchBatch(&staging[base], count, hashVals.data());
+            int generation = table.hashGeneration;
+            for (int i = 0; i < count; ++i)
+                if (generation == table.hashGeneration)
+                    table.insert(std::move(staging[base + i]), &hashVals[i * table.numHashFunctions]);
+                else
+                    table.insert(std::move(staging[base + i]));
+        }
+        return table;
+    }
+
     int size() const
     {
         return currentSize;
@@ -133,17 +222,65 @@ public:
         return array.size();
     }
 
+    HashStats stats() const
+    {
+        HashStats s;
+        s.size = currentSize;
+        s.capacity = array.size();
+        s.loadFactor = static_cast<double>(currentSize) / array.size();
+        statsPolicy.fill(s);
+        return s;
+    }
+
     bool remove(const AnyType &x)
     {
-        int currentPos = findPos(x);
-        if (!isActive(currentPos))
-            return false;
+        return removeKey(x);
+    }
 
-        array[currentPos].isActive = false;
-        return true;
+    template <typename Key, typename = EnableIfTransparent<AnyType, Key>>
+    bool remove(const Key &x)
+    {
+        return removeKey(x);
     }
 
+    // Writes the slot array together with the current hash functions, so
+    // that openMapped can serve lookups from the file without rebuilding
+    // the table. HashFamily must be trivially copyable to be stored, and
+    // free of padding so that no uninitialized bytes reach the file. The
+    // size policy is not written; it is rebuilt from the capacity.
+    void save(const std::string &path) const
+    {
+        static_assert(std::is_trivially_copyable<AnyType>::value
+                      && std::is_trivially_copyable<HashFamily>::value,
+                      "snapshots require trivially copyable elements and hash family");
+#if __cplusplus >= 201703L
+        static_assert(std::has_unique_object_representations<HashFamily>::value,
+                      "snapshots require a hash family without padding");
+#endif
+        HashState state;
+        std::memset(static_cast<void *>(&state), 0, sizeof(state));
+        state.hashFunctions = hashFunctions;
+        writeSnapshot<HashEntry>(path, SNAPSHOT_MAGIC, &state, sizeof(state), array.size(), currentSize,
+                                 [this](size_t i, HashEntry &slot)
+        {
+            slot.element = array[i].element;
+            slot.isActive = array[i].isActive;
+        });
+    }
+
+#ifdef MAPPED_FILE_POSIX
+    class Mapped;
+
+    static Mapped openMapped(const std::string &path)
+    {
+        return Mapped{path};
+    }
+#endif
+
 private:
+    template <typename, typename, typename, typename>
+    friend class HashMap;
+
     struct HashEntry
     {
         AnyType element;
@@ -156,12 +293,22 @@ private:
             : element{std::move(e)}, isActive{a} {}
     };
 
+    struct HashState
+    {
+        HashFamily hashFunctions;
+    };
+
+    static constexpr const char *SNAPSHOT_MAGIC = "CKHASH2";
+
+    SizePolicy sizer;
     std::vector<HashEntry> array;
     int currentSize;
     int numHashFunctions;
     int rehashes;
+    int hashGeneration;     // bumped whenever new hash functions are drawn
     UniformRandom r;
     HashFamily hashFunctions;
+    StatsPolicy statsPolicy;
 
     static const int ALLOWED_REHASHES = 5;
 
@@ -170,6 +317,8 @@ private:
         const int COUNT_LIMIT = 100;
         AnyType x = xx;
 
+        int displaced = 0;
+
         while (true)
         {
             int lastPos = -1;
@@ -184,6 +333,7 @@ private:
                     {
                         array[pos] = std::move(HashEntry{std::move(x), true});
                         ++currentSize;
+                        statsPolicy.recordDisplacements(displaced);
                         return true;
                     }
                 }
@@ -196,22 +346,53 @@ private:
 
                 lastPos = pos;
                 std::swap(x, array[pos].element);
+                ++displaced;
+            }
+
+            if (++rehashes > ALLOWED_REHASHES)
+            {
+                expand();
+                rehashes = 0;
             }
+            else
+                rehash();
         }
+    }
 
-        if (++rehashes > ALLOWED_REHASHES)
-        {
+    // Tries the slots of hashVals before falling back to insertHelper. A
+    // growth on the way only moves the slots, but new hash functions make
+    // hashVals useless.
+    template <typename Object>
+    bool insertHashed(Object &&x, const size_t *hashVals)
+    {
+        if (findPos(x, hashVals) != -1)
+            return false;
+
+        int generation = hashGeneration;
+        if (currentSize >= array.size() * MAX_LOAD)
             expand();
-            rehashes = 0;
-        }
-        else
-            rehash();
+
+        if (generation == hashGeneration)
+            for (int i = 0; i < numHashFunctions; ++i)
+            {
+                int pos = sizer.index(hashVals[i]);
+                if (!isActive(pos))
+                {
+                    array[pos] = HashEntry{std::forward<Object>(x), true};
+                    ++currentSize;
+                    statsPolicy.recordDisplacements(0);
+                    return true;
+                }
+            }
+        return insertHelper(std::forward<Object>(x));
     }
 
     bool insertHelper(AnyType &&x)
     {
         const int COUNT_LIMIT = 100;
 
+        int displaced = 0;
+
         while (true)
         {
             int lastPos = -1;
@@ -226,6 +407,7 @@ private:
                     {
                         array[pos] = std::move(HashEntry{std::move(x), true});
                         ++currentSize;
+                        statsPolicy.recordDisplacements(displaced);
                         return true;
                     }
                 }
@@ -238,16 +420,59 @@ private:
 
                 lastPos = pos;
                 std::swap(x, array[pos].element);
+                ++displaced;
+            }
+
+            if (++rehashes > ALLOWED_REHASHES)
+            {
+                expand();
+                rehashes = 0;
             }
+            else
+                rehash();
         }
+    }
 
-        if (++rehashes > ALLOWED_REHASHES)
-        {
+    template <typename Key>
+    bool removeKey(const Key &x)
+    {
+        int currentPos = findPos(x);
+        if (!isActive(currentPos))
+            return false;
+
+        array[currentPos].isActive = false;
+        --currentSize;
+        return true;
+    }
+
+    template <typename Key>
+    AnyType *findElement(const Key &x)
+    {
+        int currentPos = findPos(x);
+        return currentPos != -1 ? &array[currentPos].element : nullptr;
+    }
+
+    template <typename Key>
+    const AnyType *findElement(const Key &x) const
+    {
+        int currentPos = findPos(x);
+        return currentPos != -1 ? &array[currentPos].element : nullptr;
+    }
+
+    // Builds the element from args when nothing matches key. The element is
+    // constructed once and then moved along the eviction path, so it has to
+    // be found again by key once it has settled.
+    template <typename Key, typename... Args>
+    std::pair<AnyType *, bool> tryEmplace(const Key &key, Args &&... args)
+    {
+        if (AnyType *found = findElement(key))
+            return {found, false};
+
+        if (currentSize >= array.size() * MAX_LOAD)
             expand();
-            rehashes = 0;
-        }
-        else
-            rehash();
+
+        insertHelper(AnyType(std::forward<Args>(args)...));
+        return {findElement(key), true};
     }
 
     bool isActive(int currentPos) const
@@ -255,14 +480,55 @@ private:
         return currentPos != -1 && array[currentPos].isActive;
     }
 
-    int findPos(const AnyType &x) const
+    // Stores the hash of each key under every function in hashVals,
+    // numHashFunctions per key, and prefetches the slots they select.
+    void prefetchBatch(const AnyType *keys, int count, size_t *hashVals) const
+    {
+        for (int i = 0; i < count; ++i)
+            for (int j = 0; j < numHashFunctions; ++j)
+            {
+                size_t &hashVal = hashVals[i * numHashFunctions + j];
+                hashVal = hashFunctions.hash(keys[i], j);
+                prefetch(&array[sizer.index(hashVal)]);
+            }
+    }
+
+    template <typename Key>
+    int findPos(const Key &x) const
+    {
+        int probes;
+        int currentPos = probe(array.data(), sizer, hashFunctions, numHashFunctions, x, probes);
+        statsPolicy.recordProbe(probes);
+        return currentPos;
+    }
+
+    // hashVals[j] must be hash(x, j) under the current hash functions.
+    int findPos(const AnyType &x, const size_t *hashVals) const
+    {
+        for (int probes = 1; probes <= numHashFunctions; ++probes)
+        {
+            int pos = sizer.index(hashVals[probes - 1]);
+            if (array[pos].isActive && array[pos].element == x)
+            {
+                statsPolicy.recordProbe(probes);
+                return pos;
+            }
+        }
+        statsPolicy.recordProbe(numHashFunctions);
+        return -1;
+    }
+
+    template <typename Key>
+    static int probe(const HashEntry *slots, const SizePolicy &sizer,
+                     const HashFamily &hashFunctions, int numHashFunctions, const Key &x, int &probes)
     {
-        for (int i = 0; i < numHashFunctions; ++i)
+        for (probes = 1; probes <= numHashFunctions; ++probes)
         {
-            int pos = myhash(x, i);
-            if (isActive(pos) && array[pos].element == x)
+            int pos = sizer.index(hashFunctions.hash(x, probes - 1));
+            if (slots[pos].isActive && slots[pos].element == x)
                 return pos;
         }
+        probes = numHashFunctions;
         return -1;
     }
 
@@ -274,27 +540,168 @@ private:
     void rehash()
     {
         hashFunctions.generateNewFunctions();
+        ++hashGeneration;
         rehash(array.size());
     }
 
     void rehash(int newSize)
     {
-        std::vector<HashEntry> oldArray = array;
-
-        for (auto &entry : array)
-            entry.isActive = false;
+        statsPolicy.recordRehash();
+        std::vector<HashEntry> oldArray = std::move(array);
 
-        array.resize(nextPrime(newSize));
+        array = std::vector<HashEntry>(sizer.resize(newSize));
         currentSize = 0;
         for (auto &entry : oldArray)
             if (entry.isActive)
                 insert(std::move(entry.element));
     }
 
-    size_t myhash(const AnyType &x, int which) const
+    template <typename Key>
+    size_t myhash(const Key &x, int which) const
+    {
+        return sizer.index(hashFunctions.hash(x, which));
+    }
+
+#ifdef MAPPED_FILE_POSIX
+public:
+    // Read-only table backed by a file written by save(). Lookups hash with
+    // the stored functions and read the mapped slots directly.
+    class Mapped
+    {
+    public:
+        bool contains(const AnyType &x) const
+        {
+            int probes;
+            return probe(slots, sizer, state.hashFunctions, numHashFunctions, x, probes) != -1;
+        }
+
+        int size() const
+        {
+            return currentSize;
+        }
+
+        int capacity() const
+        {
+            return slotCount;
+        }
+
+    private:
+        friend class HashTable;
+
+        MappedFile file;
+        HashState state;
+        SizePolicy sizer;
+        const HashEntry *slots;
+        int slotCount;
+        int currentSize;
+        int numHashFunctions;
+
+        explicit Mapped(const std::string &path) : file{path}
+        {
+            static_assert(std::is_trivially_copyable<AnyType>::value
+                          && std::is_trivially_copyable<HashFamily>::value,
+                          "snapshots require trivially copyable elements and hash family");
+            static_assert(alignof(HashEntry) <= SNAPSHOT_ALIGN, "over-aligned elements");
+            SnapshotHeader header = readSnapshotHeader(file, SNAPSHOT_MAGIC, sizeof(state), sizeof(HashEntry));
+            std::memcpy(static_cast<void *>(&state), file.data() + sizeof(header), sizeof(state));
+            sizer = restoreSizer<SizePolicy>(header.capacity);
+            slots = reinterpret_cast<const HashEntry *>(file.data() + snapshotSlotOffset(sizeof(state)));
+            slotCount = header.capacity;
+            currentSize = header.size;
+            numHashFunctions = state.hashFunctions.getNumberOfFunctions();
+        }
+    };
+#endif
+};
+
+// Adapts a hash family for keys to map entries by hashing only the key.
+template <typename HashFamily>
+class MapHashFamily
+{
+public:
+    int getNumberOfFunctions()
+    {
+        return hashFunctions.getNumberOfFunctions();
+    }
+
+    void generateNewFunctions()
+    {
+        hashFunctions.generateNewFunctions();
+    }
+
+    template <typename Key, typename Value>
+    size_t hash(const MapEntry<Key, Value> &x, int which) const
+    {
+        return hashFunctions.hash(x.first, which);
+    }
+
+    template <typename Key>
+    size_t hash(const Key &x, int which) const
+    {
+        return hashFunctions.hash(x, which);
+    }
+
+private:
+    HashFamily hashFunctions;
+};
+
+// Key-value map over the cuckoo HashTable; HashFamily hashes Key. Entries
+// move during eviction, so pointers returned by find and tryEmplace stay
+// valid only until the next insertion or removal.
+template <typename Key, typename Value, typename HashFamily, typename SizePolicy = PrimeSizing>
+class HashMap
+{
+public:
+    typedef MapEntry<Key, Value> Entry;
+
+    explicit HashMap(int size = 101) : table{size} {}
+
+    bool contains(const Key &key) const
+    {
+        return table.contains(key);
+    }
+
+    Entry *find(const Key &key)
+    {
+        return table.findElement(key);
+    }
+
+    const Entry *find(const Key &key) const
+    {
+        return table.findElement(key);
+    }
+
+    // Constructs the value from args only when key is absent. This is the
+    // map's emplace: std::unordered_map::emplace may build an entry only to
+    // throw it away, which tryEmplace never does.
+    template <typename... Args>
+    std::pair<Entry *, bool> tryEmplace(const Key &key, Args &&... args)
+    {
+        return table.tryEmplace(key, key, std::forward<Args>(args)...);
+    }
+
+    Value &operator[](const Key &key)
+    {
+        return tryEmplace(key).first->second;
+    }
+
+    bool remove(const Key &key)
+    {
+        return table.remove(key);
+    }
+
+    void makeEmpty()
+    {
+        table.makeEmpty();
+    }
+
+    int size() const
     {
-        return hashFunctions.hash(x, which) % array.size();
+        return table.size();
     }
+
+private:
+    HashTable<Entry, MapHashFamily<HashFamily>, SizePolicy> table;
 };
 
 #endif
@@ -0,0 +1,78 @@
+#ifndef HASH_STATS_H
+#define HASH_STATS_H
+
+#include <cstdint>
+#include <algorithm>
+
+// Snapshot returned by the tables' stats(). Entry i of a histogram counts
+// events of length i; the last entry also counts everything longer.
+struct HashStats
+{
+    enum {HISTOGRAM_SIZE = 32};
+
+    int size = 0;
+    int capacity = 0;
+    double loadFactor = 0;
+    int tombstones = 0;
+    uint64_t rehashes = 0;
+    // Slots (or chain entries) examined per lookup, including the lookups
+    // done by insert and remove.
+    uint64_t probeLengths[HISTOGRAM_SIZE] = {};
+    // Elements evicted per cuckoo insertion.
+    uint64_t displacements[HISTOGRAM_SIZE] = {};
+    // Buckets by number of elements, for separate chaining.
+    uint64_t chainLengths[HISTOGRAM_SIZE] = {};
+
+    static int bucket(int length)
+    {
+        return std::min<int>(length, HISTOGRAM_SIZE - 1);
+    }
+};
+
+// Stats policies for the StatsPolicy parameter of the hash tables. The
+// hooks of NoStats are empty, so the default tables compile to the same
+// code as without instrumentation; stats() then only reports size, load
+// and chain lengths.
+struct NoStats
+{
+    void recordProbe(int) const {}
+    void recordDisplacements(int) const {}
+    void recordRehash() const {}
+    void fill(HashStats &) const {}
+};
+
+// Counts every event. The counters are plain integers updated from const
+// lookups, so a table using CountStats must not be read by several
+// threads at once.
+class CountStats
+{
+public:
+    void recordProbe(int length) const
+    {
+        ++probeLengths[HashStats::bucket(length)];
+    }
+
+    void recordDisplacements(int length) const
+    {
+        ++displacements[HashStats::bucket(length)];
+    }
+
+    void recordRehash() const
+    {
+        ++rehashes;
+    }
+
+    void fill(HashStats &s) const
+    {
+        s.rehashes = rehashes;
+        std::copy(probeLengths, probeLengths + HashStats::HISTOGRAM_SIZE, s.probeLengths);
+        std::copy(displacements, displacements + HashStats::HISTOGRAM_SIZE, s.displacements);
+    }
+
+private:
+    mutable uint64_t probeLengths[HashStats::HISTOGRAM_SIZE] = {};
+    mutable uint64_t displacements[HashStats::HISTOGRAM_SIZE] = {};
+    mutable uint64_t rehashes = 0;
+};
+
+#endif
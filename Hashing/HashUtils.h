@@ -0,0 +1,308 @@
+#ifndef HASH_UTILS_H
+#define HASH_UTILS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <functional>
+#include <thread>
+#include <type_traits>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+#include <utility>
+#include <vector>
+#include "StringHash.h"
+
+inline bool isPrime(int n)
+{
+    if (n == 1 || n % 2 == 0)
+        return false;
+    for (int i = 3; i * i <= n; i += 2)
+        if (n % i == 0)
+            return false;
+    return true;
+}
+
+inline int nextPrime(int n)
+{
+    if (n % 2 == 0)
+        ++n;
+    while (!isPrime(n))
+        n += 2;
+    return n;
+}
+
+inline uint64_t mixHash(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= UINT64_C(0xff51afd7ed558ccd);
+    h ^= h >> 33;
+    h *= UINT64_C(0xc4ceb9fe1a85ec53);
+    h ^= h >> 33;
+    return h;
+}
+
+inline uint32_t foldHash(uint64_t h)
+{
+    return static_cast<uint32_t>(h ^ (h >> 32));
+}
+
+// Element type of the HashMap variants. Entries hash and compare by key
+// only, so the underlying set tables can find them from a bare key.
+template <typename Key, typename Value>
+struct MapEntry
+{
+    Key first;
+    Value second;
+
+    MapEntry() : first{}, second{} {}
+
+    template <typename K, typename... Args, typename = typename std::enable_if<
+                  !std::is_same<typename std::decay<K>::type, MapEntry>::value>::type>
+    explicit MapEntry(K &&k, Args &&... args)
+        : first(std::forward<K>(k)), second(std::forward<Args>(args)...) {}
+};
+
+template <typename Key, typename Value>
+bool operator==(const MapEntry<Key, Value> &lhs, const MapEntry<Key, Value> &rhs)
+{
+    return lhs.first == rhs.first;
+}
+
+template <typename Key, typename Value>
+bool operator!=(const MapEntry<Key, Value> &lhs, const MapEntry<Key, Value> &rhs)
+{
+    return !(lhs == rhs);
+}
+
+template <typename Key, typename Value, typename K>
+bool operator==(const MapEntry<Key, Value> &lhs, const K &rhs)
+{
+    return lhs.first == rhs;
+}
+
+template <typename Key, typename Value, typename K>
+bool operator!=(const MapEntry<Key, Value> &lhs, const K &rhs)
+{
+    return !(lhs.first == rhs);
+}
+
+// Hash used by every table that does not take a hash family: quadratic
+// probing, separate chaining, arena chaining, Robin Hood, Swiss and the
+// shard selection of ConcurrentHashTable. Strings, string views and C
+// strings with the same characters hash alike, so a table of std::string
+// can be searched with any of them, and a hash computed once with
+// DefaultHash can be passed to several tables.
+struct DefaultHash
+{
+    template <typename T>
+    size_t operator()(const T &x) const
+    {
+        return std::hash<T>{}(x);
+    }
+
+    size_t operator()(const std::string &x) const
+    {
+        return hashBytes(x.data(), x.size());
+    }
+
+    size_t operator()(const char *x) const
+    {
+        return hashBytes(x, std::strlen(x));
+    }
+
+#if __cplusplus >= 201703L
+    size_t operator()(std::string_view x) const
+    {
+        return hashBytes(x.data(), x.size());
+    }
+#endif
+
+    template <typename Key, typename Value>
+    size_t operator()(const MapEntry<Key, Value> &x) const
+    {
+        return (*this)(x.first);
+    }
+};
+
+// Marks Key as usable for looking up HashedObj without converting it: the
+// two must hash equally and compare with ==.
+template <typename HashedObj, typename Key>
+struct TransparentKey : std::false_type {};
+
+template <>
+struct TransparentKey<std::string, const char *> : std::true_type {};
+
+template <size_t N>
+struct TransparentKey<std::string, char[N]> : std::true_type {};
+
+#if __cplusplus >= 201703L
+template <>
+struct TransparentKey<std::string, std::string_view> : std::true_type {};
+#endif
+
+template <typename Key, typename Value, typename K>
+struct TransparentKey<MapEntry<Key, Value>, K>
+    : std::integral_constant<bool, std::is_same<Key, K>::value || TransparentKey<Key, K>::value> {};
+
+template <typename HashedObj, typename Key>
+using EnableIfTransparent = typename std::enable_if<TransparentKey<HashedObj, Key>::value>::type;
+
+// Batched operations hash this many keys and prefetch their slots before
+// resolving any of them, so the cache misses overlap.
+const int PREFETCH_BATCH = 16;
+
+inline void prefetch(const void *p)
+{
+#if defined(__GNUC__)
+    __builtin_prefetch(p);
+#else
+    (void)p;
+#endif
+}
+
+inline int hardwareThreads()
+{
+    unsigned n = std::thread::hardware_concurrency();
+    return n > 0 ? n : 1;
+}
+
+// Runs task(0) .. task(count - 1) concurrently, task(0) on the calling
+// thread.
+template <typename Task>
+void parallelFor(int count, Task task)
+{
+    std::vector<std::thread> workers;
+    for (int t = 1; t < count; ++t)
+        workers.emplace_back(task, t);
+    task(0);
+    for (auto &worker : workers)
+        worker.join();
+}
+
+// Radix-partitions the indices [0, n) by regionOf(i), which must lie in
+// [0, regions), filling order with the indices grouped by region. Every
+// thread counts and then scatters its own chunk of the indices. Returns
+// the offset at which each region starts in order, followed by n.
+template <typename RegionOf>
+std::vector<size_t> partitionByRegion(size_t n, int regions, int threads,
+                                      RegionOf regionOf, std::vector<size_t> &order)
+{
+    std::vector<int> ids(n);
+    std::vector<std::vector<size_t>> counts(threads, std::vector<size_t>(regions));
+    auto chunkStart = [&](int t) { return n * t / threads; };
+
+    parallelFor(threads, [&](int t)
+    {
+        for (size_t i = chunkStart(t); i < chunkStart(t + 1); ++i)
+            ++counts[t][ids[i] = regionOf(i)];
+    });
+
+    std::vector<size_t> starts(regions + 1);
+    size_t offset = 0;
+    for (int r = 0; r < regions; ++r)
+    {
+        starts[r] = offset;
+        for (int t = 0; t < threads; ++t)
+        {
+            size_t count = counts[t][r];
+            counts[t][r] = offset;
+            offset += count;
+        }
+    }
+    starts[regions] = offset;
+
+    order.resize(n);
+    parallelFor(threads, [&](int t)
+    {
+        for (size_t i = chunkStart(t); i < chunkStart(t + 1); ++i)
+            order[counts[t][ids[i]]++] = i;
+    });
+    return starts;
+}
+
+// Sizing policies turn a hash value into a table index. Each one picks the
+// table sizes it supports through resize() and states how the quadratic
+// probing offset grows so that probing still reaches every free slot.
+
+// Prime sizes, reduced with a precomputed-reciprocal modulo instead of a
+// hardware division (Lemire, "Faster Remainder by Direct Computation").
+class PrimeSizing
+{
+public:
+    enum {PROBE_INCREMENT = 2};
+
+    int resize(int n)
+    {
+        divisor = nextPrime(n);
+        magic = UINT64_C(0xFFFFFFFFFFFFFFFF) / divisor + 1;
+        return divisor;
+    }
+
+    size_t index(size_t hashVal) const
+    {
+        uint64_t lowBits = magic * foldHash(hashVal);
+#ifdef __SIZEOF_INT128__
+        return static_cast<uint64_t>((static_cast<unsigned __int128>(lowBits) * divisor) >> 64);
+#else
+        uint64_t high = (lowBits >> 32) * divisor;
+        uint64_t low = (lowBits & 0xFFFFFFFF) * divisor;
+        return (high + (low >> 32)) >> 32;
+#endif
+    }
+
+private:
+    uint64_t magic;
+    uint32_t divisor;
+};
+
+// Prime sizes, reduced by scaling a 32-bit hash into [0, size) with one
+// multiply and a shift (Lemire fast range).
+class FastRangeSizing
+{
+public:
+    enum {PROBE_INCREMENT = 2};
+
+    int resize(int n)
+    {
+        tableSize = nextPrime(n);
+        return tableSize;
+    }
+
+    size_t index(size_t hashVal) const
+    {
+        return (static_cast<uint64_t>(foldHash(mixHash(hashVal))) * tableSize) >> 32;
+    }
+
+private:
+    uint32_t tableSize;
+};
+
+// Power-of-two sizes, reduced with a mask after a mixing finalizer. Probing
+// uses triangular offsets, which visit every slot of a power-of-two table.
+class PowerOfTwoSizing
+{
+public:
+    enum {PROBE_INCREMENT = 1};
+
+    int resize(int n)
+    {
+        int tableSize = 1;
+        while (tableSize < n)
+            tableSize *= 2;
+        mask = tableSize - 1;
+        return tableSize;
+    }
+
+    size_t index(size_t hashVal) const
+    {
+        return mixHash(hashVal) & mask;
+    }
+
+private:
+    size_t mask;
+};
+
+#endif
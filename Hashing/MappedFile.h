@@ -0,0 +1,182 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Snapshots can be written anywhere, but only mapped back where there is
+// mmap; the tables offer openMapped only when MAPPED_FILE_POSIX is set.
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPED_FILE_POSIX 1
+#endif
+
+#ifdef MAPPED_FILE_POSIX
+// Read-only mapping of a whole file, unmapped on destruction.
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string &path) : base{nullptr}, length{0}
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1)
+            throw std::runtime_error{"cannot open " + path};
+
+        struct stat st;
+        if (::fstat(fd, &st) == -1 || st.st_size == 0)
+        {
+            ::close(fd);
+            throw std::runtime_error{"cannot map " + path};
+        }
+
+        length = st.st_size;
+        void *p = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED)
+            throw std::runtime_error{"cannot map " + path};
+
+        base = static_cast<const char *>(p);
+        // Hash lookups touch pages in no particular order.
+        ::madvise(p, length, MADV_RANDOM);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&rhs) noexcept : base{rhs.base}, length{rhs.length}
+    {
+        rhs.base = nullptr;
+        rhs.length = 0;
+    }
+
+    MappedFile &operator=(MappedFile &&rhs) noexcept
+    {
+        std::swap(base, rhs.base);
+        std::swap(length, rhs.length);
+        return *this;
+    }
+
+    ~MappedFile()
+    {
+        if (base != nullptr)
+            ::munmap(const_cast<char *>(base), length);
+    }
+
+    const char *data() const
+    {
+        return base;
+    }
+
+    size_t size() const
+    {
+        return length;
+    }
+
+private:
+    const char *base;
+    size_t length;
+};
+#endif
+
+// Snapshot files hold a SnapshotHeader, the table's hashing state (hash
+// functions, if any) and then the raw slot array, which starts on a
+// SNAPSHOT_ALIGN boundary. Nothing in the file is a pointer, so a mapping
+// can be used wherever it lands, but the layout is that of the program
+// that wrote it and must be read back with the same table type.
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t slotSize;
+    uint32_t stateSize;
+    uint64_t capacity;
+    uint64_t size;
+};
+
+const size_t SNAPSHOT_ALIGN = 64;
+
+inline size_t snapshotSlotOffset(size_t stateSize)
+{
+    size_t end = sizeof(SnapshotHeader) + stateSize;
+    return (end + SNAPSHOT_ALIGN - 1) / SNAPSHOT_ALIGN * SNAPSHOT_ALIGN;
+}
+
+// Writes a snapshot of capacity slots of type Slot, where stage(i, slot)
+// assigns the fields of slot i to slot. Slots are staged a chunk at a time
+// in a zeroed buffer, so any padding between fields reaches the file as
+// zeros rather than as whatever the table's memory held.
+template <typename Slot, typename Stage>
+void writeSnapshot(const std::string &path, const char *magic,
+                   const void *state, uint32_t stateSize,
+                   uint64_t capacity, uint64_t size, Stage stage)
+{
+    SnapshotHeader header{};
+    std::strncpy(header.magic, magic, sizeof(header.magic));
+    header.slotSize = sizeof(Slot);
+    header.stateSize = stateSize;
+    header.capacity = capacity;
+    header.size = size;
+
+    static const char padding[SNAPSHOT_ALIGN] = {};
+    std::ofstream out{path, std::ios::binary | std::ios::trunc};
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(static_cast<const char *>(state), stateSize);
+    out.write(padding, snapshotSlotOffset(stateSize) - sizeof(header) - stateSize);
+
+    const uint64_t STAGED_SLOTS = 4096;
+    std::vector<Slot> staged(std::min(capacity, STAGED_SLOTS));
+    for (uint64_t first = 0; first < capacity; first += STAGED_SLOTS)
+    {
+        uint64_t count = std::min(capacity - first, STAGED_SLOTS);
+        std::memset(static_cast<void *>(staged.data()), 0, count * sizeof(Slot));
+        for (uint64_t i = 0; i < count; ++i)
+            stage(first + i, staged[i]);
+        out.write(reinterpret_cast<const char *>(staged.data()), count * sizeof(Slot));
+    }
+    out.close();
+    if (!out)
+        throw std::runtime_error{"cannot write " + path};
+}
+
+#ifdef MAPPED_FILE_POSIX
+// Checks that file is a snapshot of the expected kind and returns its header.
+inline SnapshotHeader readSnapshotHeader(const MappedFile &file, const char *magic,
+                                         uint32_t stateSize, uint32_t slotSize)
+{
+    SnapshotHeader header;
+    if (file.size() < sizeof(header))
+        throw std::runtime_error{"truncated snapshot"};
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    if (std::strncmp(header.magic, magic, sizeof(header.magic)) != 0
+        || header.stateSize != stateSize || header.slotSize != slotSize)
+        throw std::runtime_error{"snapshot does not match table type"};
+    if (file.size() < snapshotSlotOffset(stateSize) + header.capacity * slotSize)
+        throw std::runtime_error{"truncated snapshot"};
+    return header;
+}
+
+// Rebuilds the size policy of a table of capacity slots. Snapshots store
+// the capacity rather than the policy itself, and a capacity the policy
+// cannot produce would let probes run past the mapped slots.
+template <typename SizePolicy>
+SizePolicy restoreSizer(uint64_t capacity)
+{
+    SizePolicy sizer;
+    if (capacity == 0 || capacity > INT32_MAX
+        || static_cast<uint64_t>(sizer.resize(static_cast<int>(capacity))) != capacity)
+        throw std::runtime_error{"snapshot capacity does not match its size policy"};
+    return sizer;
+}
+#endif
+
+#endif
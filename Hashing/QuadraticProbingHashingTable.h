@@ -5,39 +5,84 @@
 #include <vector>
 #include <cstddef>
 #include <functional>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include "HashStats.h"
+#include "HashUtils.h"
+#include "MappedFile.h"
 
-int nextPrime(int n);
-
-template <typename HashedObj>
+template <typename HashedObj, typename SizePolicy = PrimeSizing, typename StatsPolicy = NoStats>
 class HashTable
 {
 public:
-    explicit HashTable(int size = 101) : array(nextPrime(size)) {}
+    explicit HashTable(int size = 101) : currentSize{0}, deletedSize{0}
+    {
+        array.resize(sizer.resize(size));
+    }
 
     bool contains(const HashedObj &x) const
     {
         return isActive(findPos(x));
     }
 
+    template <typename Key, typename = EnableIfTransparent<HashedObj, Key>>
+    bool contains(const Key &x) const
+    {
+        return isActive(findPos(x));
+    }
+
+    // hashVal must be DefaultHash{}(x).
+    bool findWithHash(const HashedObj &x, size_t hashVal) const
+    {
+        return isActive(findPos(x, sizer.index(hashVal)));
+    }
+
+    template <typename Key, typename = EnableIfTransparent<HashedObj, Key>>
+    bool findWithHash(const Key &x, size_t hashVal) const
+    {
+        return isActive(findPos(x, sizer.index(hashVal)));
+    }
+
+    void containsBatch(const HashedObj *keys, int n, bool *out) const
+    {
+        size_t pos[PREFETCH_BATCH];
+        for (int base = 0; base < n; base += PREFETCH_BATCH)
+        {
+            int count = std::min(PREFETCH_BATCH, n - base);
+            for (int i = 0; i < count; ++i)
+            {
+                pos[i] = myhash(keys[base + i]);
+                prefetch(&array[pos[i]]);
+            }
+            for (int i = 0; i < count; ++i)
+                out[base + i] = isActive(findPos(keys[base + i], pos[i]));
+        }
+    }
+
     void makeEmpty()
     {
         currentSize = 0;
+        deletedSize = 0;
         for (auto &entry : array)
             entry.info = EMPTY;
     }
 
     bool insert(const HashedObj &x)
     {
-        int currentPos = findPos(x);
+        return insert(x, DefaultHash{}(x));
+    }
+
+    // hashVal must be DefaultHash{}(x).
+    bool insert(const HashedObj &x, size_t hashVal)
+    {
+        int currentPos = findPos(x, sizer.index(hashVal));
         if (isActive(currentPos))
             return false;
 
         array[currentPos].element = x;
-        array[currentPos].info = ACTIVE;
-
-        if (++currentSize > array.size() / 2)
-            rehash();
-        
+        occupy(currentPos);
         return true;
     }
 
@@ -48,26 +93,101 @@ public:
             return false;
 
         array[currentPos].element = std::move(x);
-        array[currentPos].info = ACTIVE;
-
-        if (++currentSize > array.size() / 2)
-            rehash();
-        
+        occupy(currentPos);
         return true;
     }
 
+    // Keeps each key's hash rather than its slot, which a rehash part way
+    // through the batch would move.
+    int insertBatch(const HashedObj *keys, int n)
+    {
+        size_t hashes[PREFETCH_BATCH];
+        int inserted = 0;
+        for (int base = 0; base < n; base += PREFETCH_BATCH)
+        {
+            int count = std::min(PREFETCH_BATCH, n - base);
+            for (int i = 0; i < count; ++i)
+            {
+                hashes[i] = DefaultHash{}(keys[base + i]);
+                prefetch(&array[sizer.index(hashes[i])]);
+            }
+            for (int i = 0; i < count; ++i)
+                inserted += insert(keys[base + i], hashes[i]);
+        }
+        return inserted;
+    }
+
+    // Builds a table holding [first, last), sized once for all of them and
+    // filled by the given number of threads.
+    template <typename Iterator>
+    static HashTable build(Iterator first, Iterator last, int threads = hardwareThreads())
+    {
+        std::vector<HashEntry> staging;
+        for (; first != last; ++first)
+            staging.emplace_back(*first, ACTIVE);
+
+        HashTable table(staging.size() * 2 + 2);
+        table.scatter(staging, threads);
+        return table;
+    }
+
     bool remove(const HashedObj &x)
     {
-        int currentPos = findPos(x);
-        if (!isActive(currentPos))
-            return false;
+        return removeKey(x);
+    }
 
-        array[currentPos].info = DELETED;
-        return true;
+    template <typename Key, typename = EnableIfTransparent<HashedObj, Key>>
+    bool remove(const Key &x)
+    {
+        return removeKey(x);
+    }
+
+    int size() const
+    {
+        return currentSize;
+    }
+
+    HashStats stats() const
+    {
+        HashStats s;
+        s.size = currentSize;
+        s.capacity = array.size();
+        s.loadFactor = static_cast<double>(currentSize) / array.size();
+        s.tombstones = deletedSize;
+        statsPolicy.fill(s);
+        return s;
     }
 
     enum EntryType {ACTIVE, EMPTY, DELETED};
+
+    // Writes the slot array, so that openMapped can serve lookups from the
+    // file without rebuilding the table. The size policy is not written; it
+    // is rebuilt from the capacity.
+    void save(const std::string &path) const
+    {
+        static_assert(std::is_trivially_copyable<HashedObj>::value,
+                      "snapshots require trivially copyable elements");
+        writeSnapshot<HashEntry>(path, SNAPSHOT_MAGIC, nullptr, 0, array.size(), currentSize,
+                                 [this](size_t i, HashEntry &slot)
+        {
+            slot.element = array[i].element;
+            slot.info = array[i].info;
+        });
+    }
+
+#ifdef MAPPED_FILE_POSIX
+    class Mapped;
+
+    static Mapped openMapped(const std::string &path)
+    {
+        return Mapped{path};
+    }
+#endif
+
 private:
+    template <typename, typename, typename>
+    friend class HashMap;
+
     struct HashEntry
     {
         HashedObj element;
@@ -80,48 +200,347 @@ private:
             : element{std::move(e)}, info{i} {}
     };
 
+    static constexpr const char *SNAPSHOT_MAGIC = "QPHASH2";
+    static const int PARALLEL_REHASH_SLOTS = 1 << 20;
+
+    SizePolicy sizer;
     std::vector<HashEntry> array;
     int currentSize;
+    int deletedSize;
+    StatsPolicy statsPolicy;
 
     bool isActive(int currentPos) const
     {
         return array[currentPos].info == ACTIVE;
     }
 
-    int findPos(const HashedObj &x) const
+    template <typename Key>
+    bool removeKey(const Key &x)
+    {
+        int currentPos = findPos(x);
+        if (!isActive(currentPos))
+            return false;
+
+        array[currentPos].info = DELETED;
+        --currentSize;
+        if (++deletedSize > array.size() / 4)
+            purgeTombstones();
+        return true;
+    }
+
+    template <typename Key>
+    HashedObj *findElement(const Key &x)
+    {
+        int currentPos = findPos(x);
+        return isActive(currentPos) ? &array[currentPos].element : nullptr;
+    }
+
+    // Constructs the element from args directly in its slot when no
+    // element matches key.
+    template <typename Key, typename... Args>
+    std::pair<HashedObj *, bool> tryEmplace(const Key &key, Args &&... args)
+    {
+        int currentPos = findPos(key);
+        if (isActive(currentPos))
+            return {&array[currentPos].element, false};
+
+        HashedObj &slot = array[currentPos].element;
+        slot.~HashedObj();
+        try
+        {
+            new (&slot) HashedObj(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            new (&slot) HashedObj();
+            throw;
+        }
+
+        if (occupy(currentPos))
+            currentPos = findPos(key);
+        return {&array[currentPos].element, true};
+    }
+
+    template <typename Key>
+    int findPos(const Key &x) const
+    {
+        return findPos(x, myhash(x));
+    }
+
+    template <typename Key>
+    int findPos(const Key &x, int currentPos) const
+    {
+        int probes;
+        currentPos = probe(array.data(), array.size(), x, currentPos, probes);
+        statsPolicy.recordProbe(probes);
+        return currentPos;
+    }
+
+    template <typename Key>
+    static int probe(const HashEntry *slots, int slotCount, const Key &x, int currentPos, int &probes)
     {
         int offset = 1;
-        int currentPos = myhash(x);
 
-        while (array[currentPos].info != EMPTY && array[currentPos].element != x)
+        for (probes = 1; slots[currentPos].info != EMPTY && slots[currentPos].element != x; ++probes)
         {
             currentPos += offset;
-            offset += 2;
-            if (currentPos >= array.size())
-                currentPos -= array.size();
+            offset += SizePolicy::PROBE_INCREMENT;
+            if (currentPos >= slotCount)
+                currentPos -= slotCount;
         }
         return currentPos;
     }
 
-    void rehash()
+    // Live entries and tombstones together are kept to at most half the
+    // table. When tombstones are the larger share they are purged in place;
+    // otherwise the table grows. Returns whether entries were moved.
+    bool occupy(int currentPos)
     {
-        std::vector<HashEntry> oldArray = array;
+        if (array[currentPos].info == DELETED)
+            --deletedSize;
+        array[currentPos].info = ACTIVE;
+
+        if (++currentSize + deletedSize <= array.size() / 2)
+            return false;
 
+        if (deletedSize > currentSize)
+            purgeTombstones();
+        else
+            rehash();
+        return true;
+    }
+
+    // Drops every tombstone without allocating. Live entries are first
+    // marked DELETED to mean "not yet placed"; each one then moves to the
+    // first slot of its probe sequence that is not already placed, swapping
+    // with a not-yet-placed entry if that is what it lands on.
+    void purgeTombstones()
+    {
         for (auto &entry : array)
-            entry.info = EMPTY;
+            entry.info = entry.info == ACTIVE ? DELETED : EMPTY;
 
-        array.resize(nextPrime(array.size() * 2));
+        for (int i = 0; i < array.size(); ++i)
+            while (array[i].info == DELETED)
+            {
+                int pos = myhash(array[i].element);
+                for (int offset = 1; pos != i && isActive(pos); offset += SizePolicy::PROBE_INCREMENT)
+                {
+                    pos += offset;
+                    if (pos >= array.size())
+                        pos -= array.size();
+                }
+
+                if (pos == i)
+                    array[i].info = ACTIVE;
+                else if (array[pos].info == EMPTY)
+                {
+                    array[pos].element = std::move(array[i].element);
+                    array[pos].info = ACTIVE;
+                    array[i].info = EMPTY;
+                }
+                else
+                {
+                    std::swap(array[pos].element, array[i].element);
+                    array[pos].info = ACTIVE;
+                }
+            }
+
+        deletedSize = 0;
+    }
+
+    void rehash()
+    {
+        statsPolicy.recordRehash();
+        std::vector<HashEntry> oldArray = std::move(array);
+
+        array = std::vector<HashEntry>(sizer.resize(oldArray.size() * 2));
         currentSize = 0;
-        for (auto &entry : oldArray)
-            if (entry.info == ACTIVE)
-                insert(std::move(entry.element));
+        deletedSize = 0;
+        scatter(oldArray, oldArray.size() >= PARALLEL_REHASH_SLOTS ? hardwareThreads() : 1);
     }
 
-    size_t myhash(const HashedObj &x) const
+    // Moves the active entries of src into this table, which must be empty
+    // and big enough to stay at most half full. With several threads the
+    // slots are cut into one contiguous region per thread and the entries
+    // are radix-partitioned by the region of their home slot. Each thread
+    // then places its own partition, and leaves for the calling thread
+    // any entry whose probe sequence reaches another region first.
+    void scatter(std::vector<HashEntry> &src, int threads)
     {
-        static std::hash<HashedObj> hf;
-        return hf(x) % array.size();
+        if (threads <= 1)
+        {
+            for (auto &entry : src)
+                if (entry.info == ACTIVE)
+                    insert(std::move(entry.element));
+            return;
+        }
+
+        int slotCount = array.size();
+        std::vector<int> homes(src.size());
+        std::vector<size_t> order;
+        std::vector<size_t> starts = partitionByRegion(src.size(), threads + 1, threads,
+            [&](size_t i)
+            {
+                if (src[i].info != ACTIVE)
+                    return threads;
+                homes[i] = myhash(src[i].element);
+                return static_cast<int>(static_cast<int64_t>(homes[i]) * threads / slotCount);
+            }, order);
+
+        std::vector<std::vector<size_t>> deferred(threads);
+        std::vector<int> placed(threads);
+        parallelFor(threads, [&](int r)
+        {
+            int low = (static_cast<int64_t>(r) * slotCount + threads - 1) / threads;
+            int high = (static_cast<int64_t>(r + 1) * slotCount + threads - 1) / threads;
+            int count = 0;
+
+            for (size_t k = starts[r]; k < starts[r + 1]; ++k)
+            {
+                HashedObj &x = src[order[k]].element;
+                int currentPos = homes[order[k]];
+                for (int offset = 1; ; offset += SizePolicy::PROBE_INCREMENT)
+                {
+                    if (currentPos < low || currentPos >= high)
+                    {
+                        deferred[r].push_back(order[k]);
+                        break;
+                    }
+                    if (array[currentPos].info == EMPTY)
+                    {
+                        array[currentPos].element = std::move(x);
+                        array[currentPos].info = ACTIVE;
+                        ++count;
+                        break;
+                    }
+                    if (array[currentPos].element == x)
+                        break;
+
+                    currentPos += offset;
+                    if (currentPos >= slotCount)
+                        currentPos -= slotCount;
+                }
+            }
+            placed[r] = count;
+        });
+
+        for (int r = 0; r < threads; ++r)
+            currentSize += placed[r];
+        for (auto &indices : deferred)
+            for (size_t i : indices)
+                insert(std::move(src[i].element));
     }
+
+    template <typename Key>
+    size_t myhash(const Key &x) const
+    {
+        return sizer.index(DefaultHash{}(x));
+    }
+
+#ifdef MAPPED_FILE_POSIX
+public:
+    // Read-only table backed by a file written by save(). Lookups probe the
+    // mapped slots directly; pages are read in as they are first touched.
+    class Mapped
+    {
+    public:
+        bool contains(const HashedObj &x) const
+        {
+            int probes;
+            int currentPos = probe(slots, slotCount, x, sizer.index(DefaultHash{}(x)), probes);
+            return slots[currentPos].info == ACTIVE;
+        }
+
+        int size() const
+        {
+            return currentSize;
+        }
+
+        int capacity() const
+        {
+            return slotCount;
+        }
+
+    private:
+        friend class HashTable;
+
+        MappedFile file;
+        SizePolicy sizer;
+        const HashEntry *slots;
+        int slotCount;
+        int currentSize;
+
+        explicit Mapped(const std::string &path) : file{path}
+        {
+            static_assert(std::is_trivially_copyable<HashedObj>::value,
+                          "snapshots require trivially copyable elements");
+            static_assert(alignof(HashEntry) <= SNAPSHOT_ALIGN, "over-aligned elements");
+            SnapshotHeader header = readSnapshotHeader(file, SNAPSHOT_MAGIC, 0, sizeof(HashEntry));
+            sizer = restoreSizer<SizePolicy>(header.capacity);
+            slots = reinterpret_cast<const HashEntry *>(file.data() + snapshotSlotOffset(0));
+            slotCount = header.capacity;
+            currentSize = header.size;
+        }
+    };
+#endif
+};
+
+// Key-value map over HashTable. Pointers returned by find and tryEmplace
+// stay valid until the next insertion or removal.
+template <typename Key, typename Value, typename SizePolicy = PrimeSizing>
+class HashMap
+{
+public:
+    typedef MapEntry<Key, Value> Entry;
+
+    explicit HashMap(int size = 101) : table{size} {}
+
+    bool contains(const Key &key) const
+    {
+        return table.contains(key);
+    }
+
+    Entry *find(const Key &key)
+    {
+        return table.findElement(key);
+    }
+
+    const Entry *find(const Key &key) const
+    {
+        return const_cast<HashTable<Entry, SizePolicy> &>(table).findElement(key);
+    }
+
+    // Constructs the value from args only when key is absent. This is the
+    // map's emplace: std::unordered_map::emplace may build an entry only to
+    // throw it away, which tryEmplace never does.
+    template <typename... Args>
+    std::pair<Entry *, bool> tryEmplace(const Key &key, Args &&... args)
+    {
+        return table.tryEmplace(key, key, std::forward<Args>(args)...);
+    }
+
+    Value &operator[](const Key &key)
+    {
+        return tryEmplace(key).first->second;
+    }
+
+    bool remove(const Key &key)
+    {
+        return table.remove(key);
+    }
+
+    void makeEmpty()
+    {
+        table.makeEmpty();
+    }
+
+    int size() const
+    {
+        return table.size();
+    }
+
+private:
+    HashTable<Entry, SizePolicy> table;
 };
 
 #endif
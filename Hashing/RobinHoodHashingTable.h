@@ -0,0 +1,173 @@
+#ifndef ROBIN_HOOD_HASHING_TABLE_H
+#define ROBIN_HOOD_HASHING_TABLE_H
+
+#include <algorithm>
+#include <vector>
+#include <cstddef>
+#include <functional>
+#include "HashStats.h"
+#include "HashUtils.h"
+
+// Linear probing where every entry records its distance from its home slot.
+// An insert takes the slot of any entry that is closer to home than the
+// element being placed and carries that entry on, which keeps probe lengths
+// even. Removal shifts the following displaced entries back by one slot, so
+// no tombstones are ever left behind.
+template <typename HashedObj, typename SizePolicy = PowerOfTwoSizing>
+class RobinHoodHashTable
+{
+public:
+    explicit RobinHoodHashTable(int size = 101) : currentSize{0}
+    {
+        array.resize(sizer.resize(size));
+    }
+
+    bool contains(const HashedObj &x) const
+    {
+        return findPos(x) != -1;
+    }
+
+    void makeEmpty()
+    {
+        currentSize = 0;
+        for (auto &entry : array)
+            entry.dist = EMPTY;
+    }
+
+    bool insert(const HashedObj &x)
+    {
+        if (contains(x))
+            return false;
+
+        HashedObj copy = x;
+        insertHelper(std::move(copy));
+        return true;
+    }
+
+    bool insert(HashedObj &&x)
+    {
+        if (contains(x))
+            return false;
+
+        insertHelper(std::move(x));
+        return true;
+    }
+
+    bool remove(const HashedObj &x)
+    {
+        int currentPos = findPos(x);
+        if (currentPos == -1)
+            return false;
+
+        for (int next = nextPos(currentPos); array[next].dist > 0; currentPos = next, next = nextPos(next))
+        {
+            array[currentPos].element = std::move(array[next].element);
+            array[currentPos].dist = array[next].dist - 1;
+        }
+        array[currentPos].dist = EMPTY;
+        --currentSize;
+        return true;
+    }
+
+    int size() const
+    {
+        return currentSize;
+    }
+
+    int capacity() const
+    {
+        return array.size();
+    }
+
+    // The table keeps every element's distance from home, so probeLengths
+    // is exact without instrumentation: entry i counts the elements whose
+    // lookup examines i slots.
+    HashStats stats() const
+    {
+        HashStats s;
+        s.size = currentSize;
+        s.capacity = array.size();
+        s.loadFactor = static_cast<double>(currentSize) / array.size();
+        for (auto &entry : array)
+            if (entry.dist != EMPTY)
+                ++s.probeLengths[HashStats::bucket(entry.dist + 1)];
+        return s;
+    }
+
+private:
+    struct HashEntry
+    {
+        HashedObj element;
+        int dist;
+
+        HashEntry(const HashedObj &e = HashedObj{}, int d = EMPTY)
+            : element{e}, dist{d} {}
+    };
+
+    static const int EMPTY = -1;
+    static constexpr double MAX_LOAD = 0.9;
+
+    SizePolicy sizer;
+    std::vector<HashEntry> array;
+    int currentSize;
+
+    int nextPos(int currentPos) const
+    {
+        return currentPos + 1 == array.size() ? 0 : currentPos + 1;
+    }
+
+    int findPos(const HashedObj &x) const
+    {
+        int currentPos = myhash(x);
+        for (int dist = 0; array[currentPos].dist >= dist; ++dist)
+        {
+            if (array[currentPos].element == x)
+                return currentPos;
+            currentPos = nextPos(currentPos);
+        }
+        return -1;
+    }
+
+    void insertHelper(HashedObj &&x)
+    {
+        if (currentSize + 1 > array.size() * MAX_LOAD)
+            rehash();
+
+        int currentPos = myhash(x);
+        for (int dist = 0; ; ++dist)
+        {
+            HashEntry &entry = array[currentPos];
+            if (entry.dist == EMPTY)
+            {
+                entry.element = std::move(x);
+                entry.dist = dist;
+                ++currentSize;
+                return;
+            }
+            if (entry.dist < dist)
+            {
+                std::swap(x, entry.element);
+                std::swap(dist, entry.dist);
+            }
+            currentPos = nextPos(currentPos);
+        }
+    }
+
+    void rehash()
+    {
+        std::vector<HashEntry> oldArray = std::move(array);
+
+        array = std::vector<HashEntry>(sizer.resize(oldArray.size() * 2));
+        currentSize = 0;
+        for (auto &entry : oldArray)
+            if (entry.dist != EMPTY)
+                insertHelper(std::move(entry.element));
+    }
+
+    size_t myhash(const HashedObj &x) const
+    {
+        return sizer.index(DefaultHash{}(x));
+    }
+};
+
+#endif
@@ -5,76 +5,590 @@
 #include <list>
 #include <functional>
 #include <cstddef>
+#include <cstdint>
 #include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include "HashStats.h"
+#include "HashUtils.h"
 
-int nextPrime(int n);
+// Default-constructed elements kept in fixed-size chunks, so that the
+// array can be built and freed a chunk at a time.
+template <typename T>
+class ChunkedArray
+{
+public:
+    enum {CHUNK_BITS = 9, CHUNK = 1 << CHUNK_BITS};
+
+    ChunkedArray() : count{0} {}
+
+    explicit ChunkedArray(size_t n) : count{0}
+    {
+        grow(n);
+    }
+
+    ChunkedArray(ChunkedArray &&rhs) noexcept : chunks{std::move(rhs.chunks)}, count{rhs.count}
+    {
+        rhs.chunks.clear();
+        rhs.count = 0;
+    }
+
+    ChunkedArray &operator=(ChunkedArray &&rhs) noexcept
+    {
+        chunks = std::move(rhs.chunks);
+        count = rhs.count;
+        rhs.chunks.clear();
+        rhs.count = 0;
+        return *this;
+    }
+
+    size_t size() const
+    {
+        return count;
+    }
 
-template <typename HashedObj>
+    T &operator[](size_t i)
+    {
+        return chunks[i >> CHUNK_BITS][i & (CHUNK - 1)];
+    }
+
+    const T &operator[](size_t i) const
+    {
+        return chunks[i >> CHUNK_BITS][i & (CHUNK - 1)];
+    }
+
+    // Adds at most steps chunks towards n elements. Returns whether all n
+    // are there.
+    bool grow(size_t n, size_t steps = SIZE_MAX)
+    {
+        if (chunks.empty())
+            chunks.reserve((n + CHUNK - 1) / CHUNK);
+        for (; count < n && steps > 0; --steps)
+        {
+            chunks.emplace_back(new T[CHUNK]);
+            count = std::min(n, count + CHUNK);
+        }
+        return count == n;
+    }
+
+    // Frees the chunk of element i if i is its last element. Elements must
+    // be finished with in order; freed ones may not be accessed again.
+    void release(size_t i)
+    {
+        if ((i + 1) % CHUNK == 0 || i + 1 == count)
+            chunks[i >> CHUNK_BITS].reset();
+    }
+
+private:
+    std::vector<std::unique_ptr<T[]>> chunks;
+    size_t count;
+};
+
+// With Incremental set, no single operation pays for a rehash. Every
+// insert and remove moves a few old buckets over to the new array, and
+// lookups check both arrays until that finishes. Inserts ahead of a
+// rehash build the bucket array it will move into a chunk at a time, and
+// each old chunk is freed as soon as it is drained.
+template <typename HashedObj, typename SizePolicy = PrimeSizing, bool Incremental = false,
+          typename StatsPolicy = NoStats>
 class HashTable
 {
 public:
-    explicit HashTable(int size = 101) : currentSize{0}
+    explicit HashTable(int size = 101) : currentSize{0}, migratePos{0}, nextSize{0}
     {
-        theLists.resize(size);
+        theLists = BucketArray(sizer.resize(size));
     }
 
     bool contains(const HashedObj &x) const
     {
-        auto &theList = theLists[myhash(x)];
-        return std::find(theList.begin(), theList.end(), x) != theList.end();
+        return findWithHash(x, hashOf(x));
+    }
+
+    template <typename Key, typename = EnableIfTransparent<HashedObj, Key>>
+    bool contains(const Key &x) const
+    {
+        return findWithHash(x, hashOf(x));
+    }
+
+    // hashVal must be DefaultHash{}(x).
+    bool findWithHash(const HashedObj &x, size_t hashVal) const
+    {
+        return findElement(x, hashVal) != nullptr;
+    }
+
+    template <typename Key, typename = EnableIfTransparent<HashedObj, Key>>
+    bool findWithHash(const Key &x, size_t hashVal) const
+    {
+        return findElement(x, hashVal) != nullptr;
+    }
+
+    // Software-pipelined lookups: key i + 2 * AHEAD has its bucket head
+    // prefetched and key i + AHEAD its first node while key i walks its
+    // chain, so each load has AHEAD lookups' worth of time to arrive.
+    void containsBatch(const HashedObj *keys, int n, bool *out) const
+    {
+        const int AHEAD = PREFETCH_BATCH / 2;
+        size_t hashVals[PREFETCH_BATCH];
+        for (int i = -2 * AHEAD; i < n; ++i)
+        {
+            if (i >= 0)
+                out[i] = findElement(keys[i], hashVals[i % PREFETCH_BATCH]) != nullptr;
+
+            int next = i + AHEAD;
+            if (next >= 0 && next < n)
+            {
+                auto &theList = theLists[sizer.index(hashVals[next % PREFETCH_BATCH])];
+                if (!theList.empty())
+                    prefetch(&theList.front());
+            }
+
+            int ahead = i + 2 * AHEAD;
+            if (ahead < n)
+            {
+                hashVals[ahead % PREFETCH_BATCH] = hashOf(keys[ahead]);
+                prefetch(&theLists[sizer.index(hashVals[ahead % PREFETCH_BATCH])]);
+            }
+        }
     }
 
     void makeEmpty()
     {
-        for (auto &theList : theLists)
-            theList.clear();
+        for (size_t i = 0; i < theLists.size(); ++i)
+            theLists[i].clear();
+        oldLists = BucketArray();
+        migratePos = 0;
+        currentSize = 0;
     }
 
     bool insert(const HashedObj &x)
     {
-        auto &theList = theLists[myhash(x)];
-        if (std::find(theList.begin(), theList.end(), x) != theList.end())
+        return insert(x, hashOf(x));
+    }
+
+    bool insert(HashedObj &&x)
+    {
+        size_t hashVal = hashOf(x);
+        return insert(std::move(x), hashVal);
+    }
+
+    // hashVal must be DefaultHash{}(x).
+    bool insert(const HashedObj &x, size_t hashVal)
+    {
+        step();
+        if (findWithHash(x, hashVal))
+            return false;
+        theLists[sizer.index(hashVal)].push_back(x);
+        if (++currentSize > theLists.size() && !rehashing())
+            rehash();
+        return true;
+    }
+
+    bool insert(HashedObj &&x, size_t hashVal)
+    {
+        step();
+        if (findWithHash(x, hashVal))
             return false;
-        theList.push_back(x);
-        if (++currentSize > theLists.size())
+        theLists[sizer.index(hashVal)].push_back(std::move(x));
+        if (++currentSize > theLists.size() && !rehashing())
             rehash();
         return true;
     }
 
+    int insertBatch(const HashedObj *keys, int n)
+    {
+        size_t hashVals[PREFETCH_BATCH];
+        int inserted = 0;
+        for (int base = 0; base < n; base += PREFETCH_BATCH)
+        {
+            int count = std::min(PREFETCH_BATCH, n - base);
+            for (int i = 0; i < count; ++i)
+            {
+                hashVals[i] = hashOf(keys[base + i]);
+                prefetch(&theLists[sizer.index(hashVals[i])]);
+            }
+            for (int i = 0; i < count; ++i)
+                inserted += insert(keys[base + i], hashVals[i]);
+        }
+        return inserted;
+    }
+
+    // Builds a table holding [first, last) with one bucket per element.
+    // The buckets are cut into one contiguous region per thread and the
+    // elements radix-partitioned by the region of their bucket, so every
+    // thread fills its own buckets without synchronization.
+    template <typename Iterator>
+    static HashTable build(Iterator first, Iterator last, int threads = hardwareThreads())
+    {
+        std::vector<HashedObj> staging(first, last);
+        HashTable table(staging.size());
+        int bucketCount = table.theLists.size();
+        threads = std::max(threads, 1);
+
+        std::vector<int> buckets(staging.size());
+        std::vector<size_t> order;
+        std::vector<size_t> starts = partitionByRegion(staging.size(), threads, threads,
+            [&](size_t i)
+            {
+                buckets[i] = table.myhash(staging[i]);
+                return static_cast<int>(static_cast<int64_t>(buckets[i]) * threads / bucketCount);
+            }, order);
+
+        std::vector<int> placed(threads);
+        parallelFor(threads, [&](int r)
+        {
+            int count = 0;
+            for (size_t k = starts[r]; k < starts[r + 1]; ++k)
+            {
+                auto &theList = table.theLists[buckets[order[k]]];
+                HashedObj &x = staging[order[k]];
+                if (std::find(theList.begin(), theList.end(), x) == theList.end())
+                {
+                    theList.push_back(std::move(x));
+                    ++count;
+                }
+            }
+            placed[r] = count;
+        });
+
+        for (int count : placed)
+            table.currentSize += count;
+        return table;
+    }
+
     bool remove(const HashedObj &x)
     {
-        auto &theList = theLists[myhash(x)];
+        return removeKey(x);
+    }
+
+    template <typename Key, typename = EnableIfTransparent<HashedObj, Key>>
+    bool remove(const Key &x)
+    {
+        return removeKey(x);
+    }
+
+    int size() const
+    {
+        return currentSize;
+    }
+
+    // Chain lengths are counted over the current bucket array when called.
+    HashStats stats() const
+    {
+        HashStats s;
+        s.size = currentSize;
+        s.capacity = theLists.size();
+        s.loadFactor = static_cast<double>(currentSize) / theLists.size();
+        for (size_t i = 0; i < theLists.size(); ++i)
+            ++s.chainLengths[HashStats::bucket(theLists[i].size())];
+        statsPolicy.fill(s);
+        return s;
+    }
+
+private:
+    template <typename, typename, typename, bool>
+    friend class HashMap;
+
+    typedef typename std::conditional<Incremental, ChunkedArray<std::list<HashedObj>>,
+                                      std::vector<std::list<HashedObj>>>::type BucketArray;
+
+    SizePolicy sizer;
+    SizePolicy oldSizer;
+    SizePolicy nextSizer;
+    BucketArray theLists;
+    BucketArray oldLists;
+    BucketArray nextLists;      // being built for the next rehash
+    int currentSize;
+    int migratePos;
+    int nextSize;
+    StatsPolicy statsPolicy;
+
+    static const int REHASH_STEP = 4;
+    static const int PARALLEL_REHASH_BUCKETS = 1 << 20;
+
+    template <typename Key>
+    static size_t hashOf(const Key &x)
+    {
+        return DefaultHash{}(x);
+    }
+
+    template <typename Key>
+    size_t myhash(const Key &x) const
+    {
+        return sizer.index(hashOf(x));
+    }
+
+    template <typename Key>
+    size_t oldhash(const Key &x) const
+    {
+        return oldSizer.index(hashOf(x));
+    }
+
+    bool rehashing() const
+    {
+        return oldLists.size() != 0;
+    }
+
+    // Old buckets before migratePos have been drained, and may be freed.
+    bool inOldLists(size_t bucket) const
+    {
+        return rehashing() && bucket >= static_cast<size_t>(migratePos);
+    }
+
+    template <typename Key>
+    const HashedObj *findElement(const Key &x, size_t hashVal) const
+    {
+        int probes = 0;
+        const HashedObj *found = findIn(theLists[sizer.index(hashVal)], x, probes);
+        if (found == nullptr && inOldLists(oldSizer.index(hashVal)))
+            found = findIn(oldLists[oldSizer.index(hashVal)], x, probes);
+        statsPolicy.recordProbe(probes);
+        return found;
+    }
+
+    template <typename Key>
+    static const HashedObj *findIn(const std::list<HashedObj> &theList, const Key &x, int &probes)
+    {
+        for (auto &element : theList)
+        {
+            ++probes;
+            if (element == x)
+                return &element;
+        }
+        return nullptr;
+    }
+
+    template <typename Key>
+    HashedObj *findElement(const Key &x)
+    {
+        return const_cast<HashedObj *>(findElement(x, hashOf(x)));
+    }
+
+    template <typename Key>
+    const HashedObj *findElement(const Key &x) const
+    {
+        return findElement(x, hashOf(x));
+    }
+
+    // Constructs the element from args in a new list node when no element
+    // matches key. List nodes are never reallocated, so the result stays
+    // valid until that element is removed.
+    template <typename Key, typename... Args>
+    std::pair<HashedObj *, bool> tryEmplace(const Key &key, Args &&... args)
+    {
+        step();
+        size_t hashVal = hashOf(key);
+        if (const HashedObj *found = findElement(key, hashVal))
+            return {const_cast<HashedObj *>(found), false};
+
+        auto &theList = theLists[sizer.index(hashVal)];
+        theList.emplace_back(std::forward<Args>(args)...);
+        HashedObj *inserted = &theList.back();
+        if (++currentSize > theLists.size() && !rehashing())
+            rehash();
+        return {inserted, true};
+    }
+
+    template <typename Key>
+    bool removeKey(const Key &x)
+    {
+        migrate(REHASH_STEP);
+        if (!eraseFrom(theLists[myhash(x)], x)
+            && !(inOldLists(oldhash(x)) && eraseFrom(oldLists[oldhash(x)], x)))
+            return false;
+        --currentSize;
+        return true;
+    }
+
+    template <typename Key>
+    static bool eraseFrom(std::list<HashedObj> &theList, const Key &x)
+    {
         auto ite = std::find(theList.begin(), theList.end(), x);
         if (ite == theList.end())
             return false;
         theList.erase(ite);
-        --currentSize;
         return true;
     }
 
-private:
-    std::vector<std::list<HashedObj>> theLists;
-    int currentSize;
-
-    size_t myhash(const HashedObj &x) const
+    // Called by every insert. An incremental table moves a few old buckets
+    // while rehashing; otherwise, once three quarters full, it builds one
+    // more chunk of its next bucket array. That leaves a quarter of the
+    // table's size in inserts to build an array of twice that size.
+    void step()
     {
-        static std::hash<HashedObj> hf;
-        return hf(x) % theLists.size();
+        if (rehashing())
+            migrate(REHASH_STEP);
+        else if constexpr (Incremental)
+            if (currentSize >= theLists.size() / 4 * 3)
+                prepare(1);
     }
 
+    // Only called once the previous migration has finished.
     void rehash()
     {
-        std::vector<std::list<HashedObj>> oldLists = theLists;
+        statsPolicy.recordRehash();
+        oldSizer = sizer;
+        oldLists = std::move(theLists);
+        migratePos = 0;
 
-        for (auto &theList : theLists)
-            theList.clear();
+        if constexpr (Incremental)
+        {
+            // Normally built already by the operations since the last rehash.
+            prepare(SIZE_MAX);
+            sizer = nextSizer;
+            theLists = std::move(nextLists);
+            nextSize = 0;
+            migrate(REHASH_STEP);
+        }
+        else
+        {
+            theLists = BucketArray(sizer.resize(oldLists.size() * 2));
+            if (oldLists.size() >= PARALLEL_REHASH_BUCKETS && hardwareThreads() > 1)
+                scatter(hardwareThreads());
+            else
+                migrate(oldLists.size());
+        }
+    }
 
-        theLists.resize(nextPrime(theLists.size() * 2));
-        currentSize = 0;
-        for (auto &theList : oldLists)
-            for (auto &x : theList)
-                insert(std::move(x));
+    // Moves the nodes of every old bucket into the new array with several
+    // threads, relinking them as migrate does. The new buckets are cut into
+    // one contiguous region per thread. Each thread first sorts the nodes
+    // of its share of the old buckets into one list per region, noting the
+    // bucket of each, and then relinks the nodes bound for its own region,
+    // so that no list is ever touched by two threads at once.
+    void scatter(int threads)
+    {
+        size_t oldCount = oldLists.size();
+        int bucketCount = theLists.size();
+        std::vector<std::vector<std::list<HashedObj>>> staged(threads, std::vector<std::list<HashedObj>>(threads));
+        std::vector<std::vector<std::vector<int>>> buckets(threads, std::vector<std::vector<int>>(threads));
+
+        parallelFor(threads, [&](int t)
+        {
+            for (size_t i = oldCount * t / threads; i < oldCount * (t + 1) / threads; ++i)
+            {
+                auto &oldList = oldLists[i];
+                while (!oldList.empty())
+                {
+                    int bucket = myhash(oldList.front());
+                    int r = static_cast<int>(static_cast<int64_t>(bucket) * threads / bucketCount);
+                    staged[t][r].splice(staged[t][r].end(), oldList, oldList.begin());
+                    buckets[t][r].push_back(bucket);
+                }
+            }
+        });
+
+        parallelFor(threads, [&](int r)
+        {
+            for (int t = 0; t < threads; ++t)
+            {
+                auto &nodes = staged[t][r];
+                for (int bucket : buckets[t][r])
+                {
+                    auto &theList = theLists[bucket];
+                    theList.splice(theList.end(), nodes, nodes.begin());
+                }
+            }
+        });
+
+        oldLists = BucketArray();
+    }
+
+    // Adds up to the given number of chunks to the bucket array of the next
+    // rehash, which doubles the current one.
+    void prepare(size_t chunks)
+    {
+        if (nextSize == 0)
+        {
+            nextSizer = sizer;
+            nextSize = nextSizer.resize(theLists.size() * 2);
+        }
+        nextLists.grow(nextSize, chunks);
+    }
+
+    // Moves up to the given number of old buckets into the new array,
+    // relinking the existing list nodes rather than copying elements.
+    void migrate(int buckets)
+    {
+        if (!rehashing())
+            return;
+
+        for (; buckets > 0 && migratePos < oldLists.size(); --buckets, ++migratePos)
+        {
+            auto &oldList = oldLists[migratePos];
+            while (!oldList.empty())
+            {
+                auto &theList = theLists[myhash(oldList.front())];
+                theList.splice(theList.end(), oldList, oldList.begin());
+            }
+            if constexpr (Incremental)
+                oldLists.release(migratePos);
+        }
+
+        if (migratePos == oldLists.size())
+        {
+            oldLists = BucketArray();
+            migratePos = 0;
+        }
+    }
+};
+
+// Key-value map over HashTable. Entries live in list nodes, so pointers
+// returned by find and tryEmplace stay valid until the entry is removed.
+template <typename Key, typename Value, typename SizePolicy = PrimeSizing, bool Incremental = false>
+class HashMap
+{
+public:
+    typedef MapEntry<Key, Value> Entry;
+
+    explicit HashMap(int size = 101) : table{size} {}
+
+    bool contains(const Key &key) const
+    {
+        return table.contains(key);
+    }
+
+    Entry *find(const Key &key)
+    {
+        return table.findElement(key);
     }
+
+    const Entry *find(const Key &key) const
+    {
+        return table.findElement(key);
+    }
+
+    // Constructs the value from args only when key is absent. This is the
+    // map's emplace: std::unordered_map::emplace may build an entry only to
+    // throw it away, which tryEmplace never does.
+    template <typename... Args>
+    std::pair<Entry *, bool> tryEmplace(const Key &key, Args &&... args)
+    {
+        return table.tryEmplace(key, key, std::forward<Args>(args)...);
+    }
+
+    Value &operator[](const Key &key)
+    {
+        return tryEmplace(key).first->second;
+    }
+
+    bool remove(const Key &key)
+    {
+        return table.remove(key);
+    }
+
+    void makeEmpty()
+    {
+        table.makeEmpty();
+    }
+
+    int size() const
+    {
+        return table.size();
+    }
+
+private:
+    HashTable<Entry, SizePolicy, Incremental> table;
 };
 
 #endif
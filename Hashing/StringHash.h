@@ -0,0 +1,109 @@
+#ifndef STRING_HASH_H
+#define STRING_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Seedable byte-string hash following wyhash (Wang Yi, public domain).
+// Input is consumed eight bytes at a time and mixed with 64x64->128-bit
+// multiplies; strings longer than 48 bytes run three independent lanes so
+// the multiplies overlap instead of forming one serial chain.
+
+inline void hashMultiply(uint64_t &a, uint64_t &b)
+{
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 r = static_cast<unsigned __int128>(a) * b;
+    a = static_cast<uint64_t>(r);
+    b = static_cast<uint64_t>(r >> 64);
+#else
+    uint64_t ha = a >> 32, la = static_cast<uint32_t>(a);
+    uint64_t hb = b >> 32, lb = static_cast<uint32_t>(b);
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t lo = t + (rm1 << 32);
+    uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + (t < rl) + (lo < t);
+    a = lo;
+    b = hi;
+#endif
+}
+
+inline uint64_t hashMix(uint64_t a, uint64_t b)
+{
+    hashMultiply(a, b);
+    return a ^ b;
+}
+
+inline uint64_t readWord(const unsigned char *p)
+{
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t readHalfWord(const unsigned char *p)
+{
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t hashBytes(const void *key, size_t len, uint64_t seed = 0)
+{
+    static const uint64_t SECRET[4] = {
+        UINT64_C(0xa0761d6478bd642f), UINT64_C(0xe7037ed1a0b428db),
+        UINT64_C(0x8ebc6af09c88c6e3), UINT64_C(0x589965cc75374cc3)};
+
+    const unsigned char *p = static_cast<const unsigned char *>(key);
+    seed ^= hashMix(seed ^ SECRET[0], SECRET[1]);
+    uint64_t a, b;
+
+    if (len <= 16)
+    {
+        if (len >= 4)
+        {
+            size_t mid = (len >> 3) << 2;
+            a = (readHalfWord(p) << 32) | readHalfWord(p + mid);
+            b = (readHalfWord(p + len - 4) << 32) | readHalfWord(p + len - 4 - mid);
+        }
+        else if (len > 0)
+        {
+            a = (static_cast<uint64_t>(p[0]) << 16) | (static_cast<uint64_t>(p[len >> 1]) << 8) | p[len - 1];
+            b = 0;
+        }
+        else
+            a = b = 0;
+    }
+    else
+    {
+        size_t i = len;
+        if (i > 48)
+        {
+            uint64_t seed1 = seed, seed2 = seed;
+            do
+            {
+                seed = hashMix(readWord(p) ^ SECRET[1], readWord(p + 8) ^ seed);
+                seed1 = hashMix(readWord(p + 16) ^ SECRET[2], readWord(p + 24) ^ seed1);
+                seed2 = hashMix(readWord(p + 32) ^ SECRET[3], readWord(p + 40) ^ seed2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= seed1 ^ seed2;
+        }
+        while (i > 16)
+        {
+            seed = hashMix(readWord(p) ^ SECRET[1], readWord(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+        a = readWord(p + i - 16);
+        b = readWord(p + i - 8);
+    }
+
+    a ^= SECRET[1];
+    b ^= seed;
+    hashMultiply(a, b);
+    return hashMix(a ^ SECRET[0] ^ len, b ^ SECRET[1]);
+}
+
+#endif
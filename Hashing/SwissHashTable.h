@@ -0,0 +1,218 @@
+#ifndef SWISS_HASH_TABLE_H
+#define SWISS_HASH_TABLE_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <algorithm>
+#include "HashUtils.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SWISS_HASH_TABLE_SSE2 1
+#endif
+
+// Open addressing with a separate array of control bytes. A full slot's
+// control byte holds the low 7 bits of its hash, so a probe compares 16
+// tags at once and only touches an element when its tag matches.
+template <typename HashedObj>
+class SwissHashTable
+{
+public:
+    explicit SwissHashTable(int size = 101)
+    {
+        resizeSlots(slotsFor(size));
+    }
+
+    bool contains(const HashedObj &x) const
+    {
+        return findPos(x) != -1;
+    }
+
+    void makeEmpty()
+    {
+        std::fill(ctrl.begin(), ctrl.end(), EMPTY);
+        currentSize = 0;
+        deletedSize = 0;
+    }
+
+    bool insert(const HashedObj &x)
+    {
+        if (contains(x))
+            return false;
+
+        slots[prepareInsert(x)] = x;
+        return true;
+    }
+
+    bool insert(HashedObj &&x)
+    {
+        if (contains(x))
+            return false;
+
+        int pos = prepareInsert(x);
+        slots[pos] = std::move(x);
+        return true;
+    }
+
+    bool remove(const HashedObj &x)
+    {
+        int pos = findPos(x);
+        if (pos == -1)
+            return false;
+
+        ctrl[pos] = DELETED;
+        --currentSize;
+        ++deletedSize;
+        return true;
+    }
+
+    int size() const
+    {
+        return currentSize;
+    }
+
+    int capacity() const
+    {
+        return slots.size();
+    }
+
+private:
+    enum CtrlByte : signed char {EMPTY = -128, DELETED = -2};
+    enum {GROUP_WIDTH = 16};
+
+    std::vector<signed char> ctrl;
+    std::vector<HashedObj> slots;
+    size_t groupMask;
+    int currentSize;
+    int deletedSize;
+
+    static int slotsFor(int size)
+    {
+        int groups = 1;
+        while (groups * GROUP_WIDTH * 7 / 8 < size)
+            groups *= 2;
+        return groups * GROUP_WIDTH;
+    }
+
+    void resizeSlots(int newSlots)
+    {
+        ctrl.assign(newSlots, EMPTY);
+        slots.assign(newSlots, HashedObj{});
+        groupMask = newSlots / GROUP_WIDTH - 1;
+        currentSize = 0;
+        deletedSize = 0;
+    }
+
+    // Tags and group indices come from different bits, so the hash is
+    // mixed even when DefaultHash is the identity.
+    size_t myhash(const HashedObj &x) const
+    {
+        return mixHash(DefaultHash{}(x));
+    }
+
+    static signed char tagOf(size_t hashVal)
+    {
+        return static_cast<signed char>(hashVal & 0x7f);
+    }
+
+    // Bit i of the result is set when control byte i of the group equals b.
+    unsigned match(size_t group, signed char b) const
+    {
+        const signed char *g = ctrl.data() + group * GROUP_WIDTH;
+#ifdef SWISS_HASH_TABLE_SSE2
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(g));
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(b)));
+#else
+        unsigned mask = 0;
+        for (int i = 0; i < GROUP_WIDTH; ++i)
+            if (g[i] == b)
+                mask |= 1u << i;
+        return mask;
+#endif
+    }
+
+    // Empty and deleted bytes are the only ones with the sign bit set.
+    unsigned matchEmptyOrDeleted(size_t group) const
+    {
+        const signed char *g = ctrl.data() + group * GROUP_WIDTH;
+#ifdef SWISS_HASH_TABLE_SSE2
+        return _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(g)));
+#else
+        unsigned mask = 0;
+        for (int i = 0; i < GROUP_WIDTH; ++i)
+            if (g[i] < 0)
+                mask |= 1u << i;
+        return mask;
+#endif
+    }
+
+    static int lowestBit(unsigned mask)
+    {
+#if defined(__GNUC__)
+        return __builtin_ctz(mask);
+#else
+        int i = 0;
+        while (!(mask & 1))
+        {
+            mask >>= 1;
+            ++i;
+        }
+        return i;
+#endif
+    }
+
+    int findPos(const HashedObj &x) const
+    {
+        size_t hashVal = myhash(x);
+        signed char tag = tagOf(hashVal);
+        size_t group = (hashVal >> 7) & groupMask;
+
+        for (size_t step = 1; ; ++step)
+        {
+            for (unsigned mask = match(group, tag); mask; mask &= mask - 1)
+            {
+                int pos = group * GROUP_WIDTH + lowestBit(mask);
+                if (slots[pos] == x)
+                    return pos;
+            }
+            if (match(group, EMPTY) || step > groupMask)
+                return -1;
+            group = (group + step) & groupMask;
+        }
+    }
+
+    // Claims a slot for x, which must not be in the table, and returns it.
+    int prepareInsert(const HashedObj &x)
+    {
+        if ((currentSize + deletedSize + 1) * 8 > capacity() * 7)
+            rehash(currentSize * 2 >= capacity() * 7 / 8 ? capacity() * 2 : capacity());
+
+        size_t hashVal = myhash(x);
+        size_t group = (hashVal >> 7) & groupMask;
+        unsigned mask;
+        for (size_t step = 1; !(mask = matchEmptyOrDeleted(group)); ++step)
+            group = (group + step) & groupMask;
+
+        int pos = group * GROUP_WIDTH + lowestBit(mask);
+        if (ctrl[pos] == DELETED)
+            --deletedSize;
+        ctrl[pos] = tagOf(hashVal);
+        ++currentSize;
+        return pos;
+    }
+
+    void rehash(int newSlots)
+    {
+        std::vector<signed char> oldCtrl = std::move(ctrl);
+        std::vector<HashedObj> oldSlots = std::move(slots);
+
+        resizeSlots(newSlots);
+        for (size_t i = 0; i < oldSlots.size(); ++i)
+            if (oldCtrl[i] >= 0)
+                slots[prepareInsert(oldSlots[i])] = std::move(oldSlots[i]);
+    }
+};
+
+#endif
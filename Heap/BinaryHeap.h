@@ -3,19 +3,224 @@
 
 #include <vector>
 #include <algorithm>
+#include <cstddef>
+#include <new>
 #include <stdexcept>
+#include <type_traits>
 
-template <typename Comparable>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BINARY_HEAP_SSE2 1
+#endif
+
+// Allocates on cache line boundaries, so that the heap's groups of
+// children do not straddle lines.
+template <typename T>
+struct CacheAlignedAllocator
+{
+    typedef T value_type;
+    enum {CACHE_LINE = 64};
+
+    CacheAlignedAllocator() = default;
+
+    template <typename U>
+    CacheAlignedAllocator(const CacheAlignedAllocator<U> &) {}
+
+    T *allocate(size_t n)
+    {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t{CACHE_LINE}));
+    }
+
+    void deallocate(T *p, size_t)
+    {
+        ::operator delete(p, std::align_val_t{CACHE_LINE});
+    }
+
+    template <typename U>
+    bool operator==(const CacheAlignedAllocator<U> &) const
+    {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const CacheAlignedAllocator<U> &) const
+    {
+        return false;
+    }
+};
+
+// Offset of the least of the Arity children starting at children, all of
+// which are present; the first one on ties.
+template <typename Comparable, int Arity>
+struct MinChild
+{
+    static int find(const Comparable *children)
+    {
+        int best = 0;
+        for (int i = 1; i < Arity; ++i)
+            if (children[i] < children[best])
+                best = i;
+        return best;
+    }
+};
+
+#ifdef BINARY_HEAP_SSE2
+// int and float keys compare a whole group of 4 or 8 children at once:
+// the minimum is spread to every lane, and the first lane equal to it is
+// the child. float keys must not be NaN.
+struct MinChildSSE2
+{
+    static __m128i min(__m128i a, __m128i b)
+    {
+        __m128i less = _mm_cmplt_epi32(a, b);
+        return _mm_or_si128(_mm_and_si128(less, a), _mm_andnot_si128(less, b));
+    }
+
+    static __m128 min(__m128 a, __m128 b)
+    {
+        return _mm_min_ps(a, b);
+    }
+
+    static __m128i spread(__m128i m)
+    {
+        m = min(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+        return min(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    }
+
+    static __m128 spread(__m128 m)
+    {
+        m = min(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+        return min(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+    }
+
+    static int equalMask(__m128i v, __m128i m)
+    {
+        return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, m)));
+    }
+
+    static int equalMask(__m128 v, __m128 m)
+    {
+        return _mm_movemask_ps(_mm_cmpeq_ps(v, m));
+    }
+
+    static __m128i load(const int *p)
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    }
+
+    static __m128 load(const float *p)
+    {
+        return _mm_loadu_ps(p);
+    }
+
+    static int lowestBit(unsigned mask)
+    {
+#if defined(__GNUC__)
+        return __builtin_ctz(mask);
+#else
+        int i = 0;
+        while (!(mask & 1))
+        {
+            mask >>= 1;
+            ++i;
+        }
+        return i;
+#endif
+    }
+
+    template <typename Key>
+    static int find4(const Key *children)
+    {
+        auto v = load(children);
+        return lowestBit(equalMask(v, spread(v)));
+    }
+
+    template <typename Key>
+    static int find8(const Key *children)
+    {
+        auto low = load(children);
+        auto high = load(children + 4);
+        auto m = spread(min(low, high));
+        return lowestBit(equalMask(low, m) | equalMask(high, m) << 4);
+    }
+};
+
+template <>
+struct MinChild<int, 4>
+{
+    static int find(const int *children)
+    {
+        return MinChildSSE2::find4(children);
+    }
+};
+
+template <>
+struct MinChild<int, 8>
+{
+    static int find(const int *children)
+    {
+        return MinChildSSE2::find8(children);
+    }
+};
+
+template <>
+struct MinChild<float, 4>
+{
+    static int find(const float *children)
+    {
+        return MinChildSSE2::find4(children);
+    }
+};
+
+template <>
+struct MinChild<float, 8>
+{
+    static int find(const float *children)
+    {
+        return MinChildSSE2::find8(children);
+    }
+};
+#endif
+
+// A d-ary min-heap; Arity 2 is the classic binary heap. The root is kept
+// at index Arity - 1, so that the children of every node start at a
+// multiple of Arity and, with cache-aligned storage, share a cache line
+// whenever Arity * sizeof(Comparable) divides the line size. A wider heap
+// is shallower, so a pop takes fewer cache misses, at the cost of more
+// comparisons per level.
+//
+// An Addressable heap also gives every element a Handle when it is
+// inserted, which stays valid until the element is popped or erased, and
+// through which its key can be changed or the element erased in
+// O(log n). The handle of each slot is kept in a parallel array and the
+// slot of each handle in a position map; both are updated wherever an
+// element moves. A handle may be reused once its element is gone.
+template <typename Comparable, int Arity = 2, bool Addressable = false>
 class BinaryHeap
 {
+    static_assert(Arity >= 2, "a heap node needs at least two children");
+
 public:
-    explicit BinaryHeap(int capacity = 100) : heapArray(capacity + 1), currentSize{0} {}
+    typedef int Handle;
+    typedef typename std::conditional<Addressable, Handle, void>::type InsertResult;
+
+    explicit BinaryHeap(int capacity = 100)
+        : currentSize{0}, heapArray(capacity + ROOT), handles(Addressable ? capacity + ROOT : 0) {}
 
+    // In an Addressable heap, the handle of items[i] is i.
     explicit BinaryHeap(const std::vector<Comparable> &items)
-        : heapArray{items.size() + 10}, currentSize{items.size()}
+        : currentSize{static_cast<int>(items.size())}, heapArray(items.size() + ROOT + 10),
+          handles(Addressable ? heapArray.size() : 0)
     {
-        for (int i = 0; i < items.size(); ++i)
-            heapArray[i + 1] = items[i];
+        for (int i = 0; i < currentSize; ++i)
+        {
+            heapArray[i + ROOT] = items[i];
+            if (Addressable)
+            {
+                handles[i + ROOT] = i;
+                positions.push_back(i + ROOT);
+            }
+        }
         buildHeap();
     }
 
@@ -24,35 +229,46 @@ public:
         return currentSize == 0;
     }
 
+    int size() const
+    {
+        return currentSize;
+    }
+
     const Comparable &top() const
     {
         if (empty())
             throw std::runtime_error{"access empty heap top element"};
-        return heapArray[1];
+        return heapArray[ROOT];
     }
 
-    void insert(const Comparable &x)
+    InsertResult insert(const Comparable &x)
     {
-        if (currentSize == heapArray.size() - 1)
-            heapArray.resize(heapArray.size() * 2);
+        if (currentSize == capacity())
+            grow();
 
-
-        int hole = ++currentSize;
-        for (; hole > 1 && x < heapArray[hole / 2]; hole /= 2)
-            heapArray[hole] = std::move(heapArray[hole / 2]);
+        Handle h = newHandle();
+        int hole = ROOT + currentSize++;
+        for (; hole > ROOT && x < heapArray[parent(hole)]; hole = parent(hole))
+            moveTo(hole, parent(hole));
         heapArray[hole] = x;
+        setHandle(hole, h);
+        if constexpr (Addressable)
+            return h;
     }
 
-    void insert(Comparable &&x)
+    InsertResult insert(Comparable &&x)
     {
-        if (currentSize == heapArray.size() - 1)
-            heapArray.resize(heapArray.size() * 2);
-
+        if (currentSize == capacity())
+            grow();
 
-        int hole = ++currentSize;
-        for (; hole > 1 && x < heapArray[hole / 2]; hole /= 2)
-            heapArray[hole] = std::move(heapArray[hole / 2]);
+        Handle h = newHandle();
+        int hole = ROOT + currentSize++;
+        for (; hole > ROOT && x < heapArray[parent(hole)]; hole = parent(hole))
+            moveTo(hole, parent(hole));
         heapArray[hole] = std::move(x);
+        setHandle(hole, h);
+        if constexpr (Addressable)
+            return h;
     }
 
     void pop()
@@ -60,8 +276,7 @@ public:
         if (empty())
             throw std::runtime_error{"pop empty heap"};
 
-        heapArray[1] = std::move(heapArray[currentSize--]);
-        percolateDown(1);
+        removeAt(ROOT);
     }
 
     void pop(Comparable &minItem)
@@ -69,39 +284,188 @@ public:
         if (empty())
             throw std::runtime_error{"pop empty heap"};
 
-        minItem = std::move(heapArray[1]);
-        heapArray[1] = std::move(heapArray[currentSize--]);
-        percolateDown(1);
+        minItem = std::move(heapArray[ROOT]);
+        removeAt(ROOT);
     }
 
     void makeEmpty()
     {
         currentSize = 0;
+        positions.clear();
+        freeHandles.clear();
+    }
+
+    Handle topHandle() const
+    {
+        static_assert(Addressable, "only an Addressable heap has handles");
+        if (empty())
+            throw std::runtime_error{"access empty heap top element"};
+        return handles[ROOT];
+    }
+
+    bool contains(Handle h) const
+    {
+        static_assert(Addressable, "only an Addressable heap has handles");
+        return h >= 0 && h < static_cast<int>(positions.size()) && positions[h] != NO_POSITION;
+    }
+
+    const Comparable &get(Handle h) const
+    {
+        return heapArray[positionOf(h)];
+    }
+
+    void decreaseKey(Handle h, const Comparable &x)
+    {
+        int pos = positionOf(h);
+        if (heapArray[pos] < x)
+            throw std::invalid_argument{"decreaseKey given a larger key"};
+        heapArray[pos] = x;
+        percolateUp(pos);
+    }
+
+    void increaseKey(Handle h, const Comparable &x)
+    {
+        int pos = positionOf(h);
+        if (x < heapArray[pos])
+            throw std::invalid_argument{"increaseKey given a smaller key"};
+        heapArray[pos] = x;
+        percolateDown(pos);
+    }
+
+    void erase(Handle h)
+    {
+        removeAt(positionOf(h));
     }
 
 private:
+    enum {ROOT = Arity - 1, NO_POSITION = -1};
+
     int currentSize;
-    std::vector<Comparable> heapArray;
+    std::vector<Comparable, CacheAlignedAllocator<Comparable>> heapArray;
+
+    // Only used by an Addressable heap: the handle of each slot, the slot
+    // of each handle (NO_POSITION once it is gone), and the handles free
+    // for reuse.
+    std::vector<Handle> handles;
+    std::vector<int> positions;
+    std::vector<Handle> freeHandles;
+
+    static int parent(int i)
+    {
+        return (i - ROOT - 1) / Arity + ROOT;
+    }
+
+    static int firstChild(int i)
+    {
+        return Arity * (i - ROOT + 1);
+    }
+
+    // Elements that fit before the array must grow.
+    int capacity() const
+    {
+        return static_cast<int>(heapArray.size()) - ROOT;
+    }
+
+    void grow()
+    {
+        heapArray.resize(heapArray.size() * 2);
+        if (Addressable)
+            handles.resize(heapArray.size());
+    }
+
+    Handle newHandle()
+    {
+        if (!Addressable)
+            return NO_POSITION;
+        if (freeHandles.empty())
+        {
+            positions.push_back(NO_POSITION);
+            return positions.size() - 1;
+        }
+        Handle h = freeHandles.back();
+        freeHandles.pop_back();
+        return h;
+    }
+
+    int positionOf(Handle h) const
+    {
+        if (!contains(h))
+            throw std::out_of_range{"handle of an element not in the heap"};
+        return positions[h];
+    }
+
+    void setHandle(int slot, Handle h)
+    {
+        if (Addressable)
+        {
+            handles[slot] = h;
+            positions[h] = slot;
+        }
+    }
+
+    void moveTo(int to, int from)
+    {
+        heapArray[to] = std::move(heapArray[from]);
+        if (Addressable)
+            setHandle(to, handles[from]);
+    }
+
+    // Fills slot with the last element and restores the heap order there.
+    void removeAt(int slot)
+    {
+        if (Addressable)
+        {
+            positions[handles[slot]] = NO_POSITION;
+            freeHandles.push_back(handles[slot]);
+        }
+
+        int last = ROOT + --currentSize;
+        if (slot == last)
+            return;
+        moveTo(slot, last);
+        if (slot > ROOT && heapArray[slot] < heapArray[parent(slot)])
+            percolateUp(slot);
+        else
+            percolateDown(slot);
+    }
 
     void buildHeap()
     {
-        for (int i = currentSize / 2; i > 0; --i)
-            percolateDown(i);
+        if (currentSize > 1)
+            for (int i = parent(ROOT + currentSize - 1); i >= ROOT; --i)
+                percolateDown(i);
+    }
+
+    void percolateUp(int hole)
+    {
+        Comparable tmp = std::move(heapArray[hole]);
+        Handle h = Addressable ? handles[hole] : NO_POSITION;
+        for (; hole > ROOT && tmp < heapArray[parent(hole)]; hole = parent(hole))
+            moveTo(hole, parent(hole));
+        heapArray[hole] = std::move(tmp);
+        setHandle(hole, h);
     }
 
     void percolateDown(int hole)
     {
+        int last = ROOT + currentSize - 1;
         Comparable tmp = std::move(heapArray[hole]);
-        for (int child = hole * 2; child <= currentSize; hole = child, child = hole * 2)
+        Handle h = Addressable ? handles[hole] : NO_POSITION;
+        for (int child = firstChild(hole); child <= last; hole = child, child = firstChild(hole))
         {
-            if (child != currentSize && heapArray[child + 1] < heapArray[child])
-                ++child;
+            if (child + Arity - 1 <= last)
+                child += MinChild<Comparable, Arity>::find(&heapArray[child]);
+            else
+                for (int i = child + 1; i <= last; ++i)
+                    if (heapArray[i] < heapArray[child])
+                        child = i;
             if (heapArray[child] < tmp)
-                heapArray[hole] = std::move(heapArray[child]);
+                moveTo(hole, child);
             else
                 break;
         }
         heapArray[hole] = std::move(tmp);
+        setHandle(hole, h);
     }
 };
 
@@ -0,0 +1,133 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+// Fixed-capacity multi-producer multi-consumer FIFO queue over a ring of
+// cells (Vyukov's bounded MPMC queue). Each cell carries a sequence number
+// saying whose turn it is: a producer claims the cell at enqueuePos once
+// its sequence equals that position, and a consumer the cell at dequeuePos
+// once it is one past it. A push or pop is one compare-and-swap on its
+// position plus one store to the cell, and never allocates.
+//
+// tryPush and tryPop may be called from any number of threads at once;
+// construction and destruction may not.
+template <typename Object>
+class BoundedQueue
+{
+public:
+    // The capacity is rounded up to a power of two.
+    explicit BoundedQueue(int capacity)
+        : mask{roundUp(capacity) - 1}, cells{new Cell[mask + 1]},
+          enqueuePos{0}, dequeuePos{0}
+    {
+        for (size_t i = 0; i <= mask; ++i)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    ~BoundedQueue()
+    {
+        for (size_t pos = dequeuePos.load(); pos != enqueuePos.load(); ++pos)
+            cells[pos & mask].value()->~Object();
+    }
+
+    int capacity() const
+    {
+        return mask + 1;
+    }
+
+    // Returns false, leaving x alone, if the queue is full.
+    bool tryPush(const Object &x)
+    {
+        size_t pos;
+        Cell *cell = claim(enqueuePos, 0, pos);
+        if (cell == nullptr)
+            return false;
+        new (cell->storage) Object(x);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPush(Object &&x)
+    {
+        size_t pos;
+        Cell *cell = claim(enqueuePos, 0, pos);
+        if (cell == nullptr)
+            return false;
+        new (cell->storage) Object(std::move(x));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Moves the front element to x. Returns false if the queue is empty.
+    bool tryPop(Object &x)
+    {
+        size_t pos;
+        Cell *cell = claim(dequeuePos, 1, pos);
+        if (cell == nullptr)
+            return false;
+        Object *value = cell->value();
+        x = std::move(*value);
+        value->~Object();
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        alignas(Object) unsigned char storage[sizeof(Object)];
+
+        Object *value()
+        {
+            return reinterpret_cast<Object *>(storage);
+        }
+    };
+
+    const size_t mask;
+    std::unique_ptr<Cell[]> cells;
+    alignas(64) std::atomic<size_t> enqueuePos;
+    alignas(64) std::atomic<size_t> dequeuePos;
+
+    static size_t roundUp(int capacity)
+    {
+        size_t n = 2;
+        while (n < static_cast<size_t>(capacity))
+            n *= 2;
+        return n;
+    }
+
+    // Claims the next cell from next for a producer (lag 0) or consumer
+    // (lag 1), setting p to its position, or returns nullptr if that cell
+    // is not ready: the queue is full or empty.
+    Cell *claim(std::atomic<size_t> &next, size_t lag, size_t &p)
+    {
+        p = next.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell *cell = &cells[p & mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(p + lag);
+            if (diff == 0)
+            {
+                if (next.compare_exchange_weak(p, p + 1, std::memory_order_relaxed))
+                    return cell;
+            }
+            else if (diff < 0)
+                return nullptr;
+            else
+                p = next.load(std::memory_order_relaxed);
+        }
+    }
+};
+
+#endif
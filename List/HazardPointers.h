@@ -0,0 +1,186 @@
+#ifndef HAZARD_POINTERS_H
+#define HAZARD_POINTERS_H
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// Safe memory reclamation for lock-free structures (Michael, "Hazard
+// Pointers: Safe Memory Reclamation for Lock-Free Objects"). A thread
+// publishes the nodes it is about to dereference in its hazard slots;
+// a removed node is retired rather than deleted, and is only deleted once
+// no slot of any thread holds it.
+//
+// Each thread gets a record of SLOTS hazards the first time it uses them,
+// and gives it back when it exits. Its retired nodes are scanned once
+// there are RETIRE_THRESHOLD of them; whatever is still hazardous when it
+// exits is left for the other threads to delete.
+class HazardPointers
+{
+public:
+    enum {SLOTS = 2, RETIRE_THRESHOLD = 128};
+
+    // Loads src into hazard slot, reloading until the published value is
+    // still current, so the node cannot have been deleted in between.
+    template <typename T>
+    static T *protect(int slot, const std::atomic<T *> &src)
+    {
+        std::atomic<void *> &hazard = local().record->hazards[slot];
+        T *p = src.load();
+        for (;;)
+        {
+            hazard.store(p);
+            T *q = src.load();
+            if (q == p)
+                return p;
+            p = q;
+        }
+    }
+
+    // Publishes p, which the caller must then check is still reachable.
+    static void set(int slot, void *p)
+    {
+        local().record->hazards[slot].store(p);
+    }
+
+    static void clear()
+    {
+        for (auto &hazard : local().record->hazards)
+            hazard.store(nullptr, std::memory_order_release);
+    }
+
+    // Deletes p once no thread has it in a hazard slot.
+    template <typename T>
+    static void retire(T *p)
+    {
+        ThreadState &state = local();
+        state.retired.push_back({p, [](void *q) { delete static_cast<T *>(q); }});
+        if (state.retired.size() >= RETIRE_THRESHOLD)
+            scan(state.retired);
+    }
+
+private:
+    struct Record
+    {
+        std::atomic<void *> hazards[SLOTS];
+        std::atomic<bool> active;
+        Record *next;
+    };
+
+    struct Retired
+    {
+        void *p;
+        void (*deleter)(void *);
+    };
+
+    // Nodes left behind by threads that have exited.
+    struct Orphans
+    {
+        std::mutex lock;
+        std::vector<Retired> nodes;
+
+        ~Orphans()
+        {
+            for (auto &r : nodes)
+                r.deleter(r.p);
+        }
+    };
+
+    struct ThreadState
+    {
+        Record *record;
+        std::vector<Retired> retired;
+
+        ThreadState() : record{acquire()}
+        {
+        }
+
+        ~ThreadState()
+        {
+            for (auto &hazard : record->hazards)
+                hazard.store(nullptr);
+            scan(retired);
+            if (!retired.empty())
+            {
+                Orphans &o = orphans();
+                std::lock_guard<std::mutex> guard{o.lock};
+                o.nodes.insert(o.nodes.end(), retired.begin(), retired.end());
+            }
+            record->active.store(false, std::memory_order_release);
+        }
+    };
+
+    // Records are never freed, so a list of them only ever grows to the
+    // largest number of threads that were alive at once.
+    static std::atomic<Record *> &records()
+    {
+        static std::atomic<Record *> head{nullptr};
+        return head;
+    }
+
+    static Orphans &orphans()
+    {
+        static Orphans o;
+        return o;
+    }
+
+    static ThreadState &local()
+    {
+        thread_local ThreadState state;
+        return state;
+    }
+
+    static Record *acquire()
+    {
+        // Constructed first so that it outlives every ThreadState.
+        orphans();
+        for (Record *r = records().load(); r != nullptr; r = r->next)
+        {
+            bool idle = false;
+            if (!r->active.load() && r->active.compare_exchange_strong(idle, true))
+                return r;
+        }
+
+        Record *r = new Record;
+        for (auto &hazard : r->hazards)
+            hazard.store(nullptr);
+        r->active.store(true);
+        r->next = records().load();
+        while (!records().compare_exchange_weak(r->next, r))
+            ;
+        return r;
+    }
+
+    // Deletes the retired nodes that no hazard slot holds, adopting any
+    // orphans first if no other thread is doing so.
+    static void scan(std::vector<Retired> &retired)
+    {
+        Orphans &o = orphans();
+        std::unique_lock<std::mutex> guard{o.lock, std::try_to_lock};
+        if (guard.owns_lock() && !o.nodes.empty())
+        {
+            retired.insert(retired.end(), o.nodes.begin(), o.nodes.end());
+            o.nodes.clear();
+        }
+        if (guard.owns_lock())
+            guard.unlock();
+
+        std::vector<void *> hazards;
+        for (Record *r = records().load(); r != nullptr; r = r->next)
+            for (auto &hazard : r->hazards)
+                if (void *p = hazard.load())
+                    hazards.push_back(p);
+        std::sort(hazards.begin(), hazards.end());
+
+        auto kept = std::partition(retired.begin(), retired.end(), [&](const Retired &r)
+        {
+            return std::binary_search(hazards.begin(), hazards.end(), r.p);
+        });
+        for (auto itr = kept; itr != retired.end(); ++itr)
+            itr->deleter(itr->p);
+        retired.erase(kept, retired.end());
+    }
+};
+
+#endif
@@ -2,8 +2,17 @@
 #define LIST_H
 
 #include <algorithm>
-
-template <typename Object>
+#include <memory>
+#include <type_traits>
+#include "NodePool.h"
+
+// Nodes come from a NodePool shared through a shared_ptr. Each list gets a
+// pool of its own unless it is constructed with another list's nodePool();
+// lists sharing a pool can splice nodes between them in O(1).
+//
+// A NodePool<Node> provides void *allocate(), void deallocate(void *) and
+// void recycleAll(), which takes back every node at once.
+template <typename Object, template <typename> class NodePool = SlabPool>
 class List
 {
 private:
@@ -17,7 +26,7 @@ private:
             : data{d}, prev{p}, next{n}
         {}
 
-        Node(const Object &&d, Node *p = nullptr, Node *n = nullptr)
+        Node(Object &&d, Node *p = nullptr, Node *n = nullptr)
             : data{std::move(d)}, prev{p}, next{n}
         {}
     };
@@ -79,7 +88,7 @@ public:
 
         const_iterator(Node *p) : current{p} {}
 
-        friend class List<Object>;
+        friend class List;
     };
 
     class iterator : public const_iterator
@@ -95,6 +104,7 @@ public:
         iterator &operator++()
         {
             this->current = this->current->next;
+            return *this;
         }
 
         iterator  operator++(int)
@@ -107,6 +117,7 @@ public:
         iterator &operator--()
         {
             this->current = this->current->prev;
+            return *this;
         }
 
         iterator  operator--(int)
@@ -119,23 +130,32 @@ public:
     protected:
         iterator(Node *p) : const_iterator{p} {}
 
-        friend class List<Object>;
+        friend class List;
     };
 
+    typedef NodePool<Node> Pool;
+
 public:
-    List()
+    List() : pool{std::make_shared<Pool>()}
+    {
+        init();
+    }
+
+    explicit List(const std::shared_ptr<Pool> &sharedPool) : pool{sharedPool}
     {
         init();
     }
 
     ~List()
     {
+        if (head == nullptr)
+            return;
         clear();
         delete head;
         delete tail;
     }
 
-    List(const List &rhs)
+    List(const List &rhs) : pool{std::make_shared<Pool>()}
     {
         init();
         for (auto &x : rhs)
@@ -150,7 +170,7 @@ public:
     }
 
     List(List &&rhs)
-        : theSize{rhs.theSize}, head{rhs.head}, tail{rhs.tail}
+        : theSize{rhs.theSize}, head{rhs.head}, tail{rhs.tail}, pool{std::move(rhs.pool)}
     {
         rhs.theSize = 0;
         rhs.head = nullptr;
@@ -162,10 +182,17 @@ public:
         std::swap(theSize, rhs.theSize);
         std::swap(head, rhs.head);
         std::swap(tail, rhs.tail);
+        std::swap(pool, rhs.pool);
 
         return *this;
     }
 
+    // The pool this list takes its nodes from, to share with other lists.
+    const std::shared_ptr<Pool> &nodePool() const
+    {
+        return pool;
+    }
+
     iterator begin()
     {
         return iterator(head->next);
@@ -196,10 +223,32 @@ public:
         return size() == 0;
     }
 
+    // A list that is the only user of its pool hands all the nodes back at
+    // once, and only visits them to run the destructors if there are any.
     void clear()
     {
-        while (!empty())
-            pop_front();
+        if (pool.use_count() == 1)
+        {
+            if (!std::is_trivially_destructible<Object>::value)
+                for (Node *p = head->next; p != tail; )
+                {
+                    Node *next = p->next;
+                    p->~Node();
+                    p = next;
+                }
+            pool->recycleAll();
+        }
+        else
+            for (Node *p = head->next; p != tail; )
+            {
+                Node *next = p->next;
+                release(p);
+                p = next;
+            }
+
+        head->next = tail;
+        tail->prev = head;
+        theSize = 0;
     }
 
     Object &front()
@@ -255,24 +304,25 @@ public:
     iterator insert(iterator itr, const Object &x)
     {
         Node *p = itr.current;
+        Node *n = new (pool->allocate()) Node(x, p->prev, p);
         ++theSize;
-        return iterator{p->prev = p->prev->next = new Node(x, p->prev, p)};
+        return iterator{p->prev = p->prev->next = n};
     }
 
     iterator insert(iterator itr, Object &&x)
     {
         Node *p = itr.current;
+        Node *n = new (pool->allocate()) Node(std::move(x), p->prev, p);
         ++theSize;
-        return iterator{p->prev = p->prev->next = new Node(std::move(x), p->prev, p)};
+        return iterator{p->prev = p->prev->next = n};
     }
 
     iterator erase(iterator itr)
     {
         Node *p = itr.current;
         iterator retVal(p->next);
-        p->prev->next = p->next;
-        p->next->prev = p->prev;
-        delete p;
+        unlink(p, p);
+        release(p);
         --theSize;
         return retVal;
     }
@@ -283,10 +333,81 @@ public:
         return to;
     }
 
+    // Moves all of rhs before itr. O(1) when both lists share a pool;
+    // otherwise the elements are moved one by one.
+    void splice(iterator itr, List &rhs)
+    {
+        if (&rhs != this)
+            splice(itr, rhs, rhs.begin(), rhs.end(), rhs.theSize);
+    }
+
+    // Moves the element at from in rhs, which may be this list, before itr.
+    void splice(iterator itr, List &rhs, iterator from)
+    {
+        if (itr == from || itr.current == from.current->next)
+            return;
+        splice(itr, rhs, from, iterator{from.current->next}, 1);
+    }
+
+    // Moves [from, to) of rhs before itr, which must not be in that range.
+    // Takes time linear in the length of the range, to count it, unless rhs
+    // is this list.
+    void splice(iterator itr, List &rhs, iterator from, iterator to)
+    {
+        int count = 0;
+        if (&rhs != this)
+            for (iterator p = from; p != to; ++p)
+                ++count;
+        splice(itr, rhs, from, to, count);
+    }
+
 private:
     int theSize;
     Node *head;
     Node *tail;
+    std::shared_ptr<Pool> pool;
+
+    void splice(iterator itr, List &rhs, iterator from, iterator to, int count)
+    {
+        if (from == to)
+            return;
+        if (pool != rhs.pool)
+        {
+            while (from != to)
+            {
+                insert(itr, std::move(*from));
+                from = rhs.erase(from);
+            }
+            return;
+        }
+
+        Node *first = from.current;
+        Node *last = to.current->prev;
+        unlink(first, last);
+        Node *p = itr.current;
+        first->prev = p->prev;
+        last->next = p;
+        p->prev->next = first;
+        p->prev = last;
+        if (&rhs != this)
+        {
+            rhs.theSize -= count;
+            theSize += count;
+        }
+    }
+
+    // Detaches the nodes first through last from their neighbours.
+    static void unlink(Node *first, Node *last)
+    {
+        first->prev->next = last->next;
+        last->next->prev = first->prev;
+    }
+
+    void release(Node *p)
+    {
+        p->~Node();
+        pool->deallocate(p);
+    }
 
     void init()
     {
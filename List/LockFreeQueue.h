@@ -0,0 +1,138 @@
+#ifndef LOCK_FREE_QUEUE_H
+#define LOCK_FREE_QUEUE_H
+
+#include <atomic>
+#include <new>
+#include <utility>
+#include "HazardPointers.h"
+
+// Unbounded multi-producer multi-consumer FIFO queue (Michael and Scott,
+// "Simple, Fast, and Practical Non-Blocking and Blocking Concurrent Queue
+// Algorithms"). A linked list of nodes like List's, with a dummy node at
+// the front: head points at the dummy and the first element lives in the
+// node after it. Dequeued nodes are reclaimed through HazardPointers.
+//
+// push and tryPop may be called from any number of threads at once;
+// construction and destruction may not.
+template <typename Object>
+class LockFreeQueue
+{
+public:
+    LockFreeQueue()
+    {
+        Node *dummy = new Node;
+        head.store(dummy);
+        tail.store(dummy);
+    }
+
+    LockFreeQueue(const LockFreeQueue &) = delete;
+    LockFreeQueue &operator=(const LockFreeQueue &) = delete;
+
+    ~LockFreeQueue()
+    {
+        Node *p = head.load();
+        Node *next = p->next.load();
+        delete p;
+        for (p = next; p != nullptr; p = next)
+        {
+            next = p->next.load();
+            p->value()->~Object();
+            delete p;
+        }
+    }
+
+    void push(const Object &x)
+    {
+        Node *node = new Node;
+        new (node->storage) Object(x);
+        link(node);
+    }
+
+    void push(Object &&x)
+    {
+        Node *node = new Node;
+        new (node->storage) Object(std::move(x));
+        link(node);
+    }
+
+    // Moves the front element to x. Returns false if the queue is empty.
+    bool tryPop(Object &x)
+    {
+        for (;;)
+        {
+            Node *h = HazardPointers::protect(0, head);
+            Node *t = tail.load();
+            Node *next = h->next.load();
+            HazardPointers::set(1, next);
+            if (h != head.load())
+                continue;
+
+            if (next == nullptr)
+            {
+                HazardPointers::clear();
+                return false;
+            }
+            if (h == t)
+            {
+                // The tail is lagging behind an enqueue; help it along.
+                tail.compare_exchange_weak(t, next);
+                continue;
+            }
+            if (head.compare_exchange_weak(h, next))
+            {
+                // next is the new dummy; only this thread touches its value.
+                Object *value = next->value();
+                x = std::move(*value);
+                value->~Object();
+                HazardPointers::clear();
+                HazardPointers::retire(h);
+                return true;
+            }
+        }
+    }
+
+    // Only a snapshot when other threads are using the queue.
+    bool empty() const
+    {
+        return head.load()->next.load() == nullptr;
+    }
+
+private:
+    struct Node
+    {
+        std::atomic<Node *> next{nullptr};
+        alignas(Object) unsigned char storage[sizeof(Object)];
+
+        Object *value()
+        {
+            return reinterpret_cast<Object *>(storage);
+        }
+    };
+
+    // The two ends are written by different threads; keep them on
+    // separate cache lines.
+    alignas(64) std::atomic<Node *> head;
+    alignas(64) std::atomic<Node *> tail;
+
+    void link(Node *node)
+    {
+        for (;;)
+        {
+            Node *t = HazardPointers::protect(0, tail);
+            Node *next = t->next.load();
+            if (t != tail.load())
+                continue;
+
+            if (next != nullptr)
+                tail.compare_exchange_weak(t, next);
+            else if (t->next.compare_exchange_weak(next, node))
+            {
+                tail.compare_exchange_strong(t, node);
+                HazardPointers::clear();
+                return;
+            }
+        }
+    }
+};
+
+#endif
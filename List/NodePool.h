@@ -0,0 +1,113 @@
+#ifndef NODE_POOL_H
+#define NODE_POOL_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// Hands out raw storage for Node objects from slabs of many nodes at a time.
+// Released nodes go on a free list and are reused before any new slab is
+// taken, so steady insert/erase churn never calls the allocator. Slabs
+// double in size up to MAX_SLAB_NODES and are only returned to the heap
+// when the pool is destroyed. Not thread safe; lists sharing a pool must
+// be used by one thread at a time.
+template <typename Node>
+class SlabPool
+{
+public:
+    SlabPool() : freeList{nullptr}, slab{0}, carve{nullptr}, limit{nullptr}
+    {
+    }
+
+    SlabPool(const SlabPool &) = delete;
+    SlabPool &operator=(const SlabPool &) = delete;
+
+    ~SlabPool()
+    {
+        for (auto &s : slabs)
+            ::operator delete(s.nodes);
+    }
+
+    // Storage for one Node; the caller constructs it.
+    void *allocate()
+    {
+        if (freeList != nullptr)
+        {
+            FreeNode *p = freeList;
+            freeList = p->next;
+            return p;
+        }
+        if (carve == limit)
+            nextSlab();
+        return carve++;
+    }
+
+    // Takes back storage whose Node has been destroyed.
+    void deallocate(void *p)
+    {
+        freeList = new (p) FreeNode{freeList};
+    }
+
+    // Takes back every node at once. Only valid when none is in use.
+    void recycleAll()
+    {
+        freeList = nullptr;
+        slab = 0;
+        carve = limit = nullptr;
+        if (!slabs.empty())
+            useSlab(0);
+    }
+
+private:
+    enum {FIRST_SLAB_NODES = 32, MAX_SLAB_NODES = 4096};
+
+    struct FreeNode
+    {
+        FreeNode *next;
+    };
+
+    struct Slot
+    {
+        alignas(Node) unsigned char node[sizeof(Node)];
+    };
+
+    static_assert(sizeof(Slot) >= sizeof(FreeNode) && alignof(Slot) >= alignof(FreeNode),
+                  "a free node is kept in the storage of a Node");
+
+    struct Slab
+    {
+        Slot *nodes;
+        size_t count;
+    };
+
+    std::vector<Slab> slabs;
+    FreeNode *freeList;
+    size_t slab;
+    Slot *carve;
+    Slot *limit;
+
+    // Carves from the slab after the current one, adding it if needed.
+    void nextSlab()
+    {
+        if (carve != nullptr)
+            ++slab;
+        if (slab == slabs.size())
+        {
+            size_t count = slabs.empty() ? size_t{FIRST_SLAB_NODES} : slabs.back().count * 2;
+            if (count > MAX_SLAB_NODES)
+                count = MAX_SLAB_NODES;
+            slabs.reserve(slabs.size() + 1);
+            slabs.push_back({static_cast<Slot *>(::operator new(count * sizeof(Slot))), count});
+        }
+        useSlab(slab);
+    }
+
+    void useSlab(size_t s)
+    {
+        slab = s;
+        carve = slabs[s].nodes;
+        limit = carve + slabs[s].count;
+    }
+};
+
+#endif
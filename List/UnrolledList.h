@@ -0,0 +1,460 @@
+#ifndef UNROLLED_LIST_H
+#define UNROLLED_LIST_H
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+// A List that keeps a block of elements in each node, about BlockBytes
+// including the links, so that a traversal reads contiguous memory instead
+// of chasing a pointer per element. A full node is split when inserting
+// into it, and a node that falls below half full after an erase is merged
+// with the next one when they fit together.
+//
+// The interface is List's, but an insert or erase moves the other elements
+// of its node, so it invalidates iterators into that node (and, on a split
+// or merge, into the node next to it) as well as the erased one.
+template <typename Object, size_t BlockBytes = 128>
+class UnrolledList
+{
+private:
+    enum {HEADER_BYTES = 2 * sizeof(void *) + sizeof(int)};
+    static const int NODE_CAPACITY = BlockBytes > HEADER_BYTES + sizeof(Object)
+                                     ? (BlockBytes - HEADER_BYTES) / sizeof(Object) : 1;
+    static const size_t NODE_ALIGN = BlockBytes % 64 == 0 ? 64 : alignof(void *);
+
+    struct alignas(NODE_ALIGN) Node
+    {
+        Node *prev;
+        Node *next;
+        int count;
+        alignas(Object) unsigned char storage[NODE_CAPACITY * sizeof(Object)];
+
+        Node(Node *p = nullptr, Node *n = nullptr) : prev{p}, next{n}, count{0}
+        {}
+
+        Object *elements()
+        {
+            return reinterpret_cast<Object *>(storage);
+        }
+
+        Object &at(int i)
+        {
+            return elements()[i];
+        }
+    };
+
+public:
+    class const_iterator
+    {
+    public:
+        const_iterator() : current{nullptr}, index{0} {}
+
+        const Object &operator*() const
+        {
+            return retrieve();
+        }
+
+        const_iterator &operator++()
+        {
+            if (++index == current->count)
+            {
+                current = current->next;
+                index = 0;
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            const_iterator old = *this;
+            ++(*this);
+            return old;
+        }
+
+        const_iterator &operator--()
+        {
+            if (index-- == 0)
+            {
+                current = current->prev;
+                index = current->count - 1;
+            }
+            return *this;
+        }
+
+        const_iterator operator--(int)
+        {
+            const_iterator old = *this;
+            --(*this);
+            return old;
+        }
+
+        bool operator==(const const_iterator &rhs) const
+        {
+            return current == rhs.current && index == rhs.index;
+        }
+
+        bool operator!=(const const_iterator &rhs) const
+        {
+            return !(*this == rhs);
+        }
+
+    protected:
+        Node *current;
+        int index;
+
+        Object &retrieve() const
+        {
+            return current->at(index);
+        }
+
+        const_iterator(Node *p, int i) : current{p}, index{i} {}
+
+        friend class UnrolledList;
+    };
+
+    class iterator : public const_iterator
+    {
+    public:
+        iterator() {}
+
+        Object &operator*()
+        {
+            return const_iterator::retrieve();
+        }
+
+        iterator &operator++()
+        {
+            const_iterator::operator++();
+            return *this;
+        }
+
+        iterator  operator++(int)
+        {
+            iterator old = *this;
+            ++(*this);
+            return old;
+        }
+
+        iterator &operator--()
+        {
+            const_iterator::operator--();
+            return *this;
+        }
+
+        iterator  operator--(int)
+        {
+            iterator old = *this;
+            --(*this);
+            return old;
+        }
+
+    protected:
+        iterator(Node *p, int i) : const_iterator{p, i} {}
+
+        friend class UnrolledList;
+    };
+
+public:
+    UnrolledList()
+    {
+        init();
+    }
+
+    ~UnrolledList()
+    {
+        if (head == nullptr)
+            return;
+        clear();
+        delete head;
+        delete tail;
+    }
+
+    UnrolledList(const UnrolledList &rhs)
+    {
+        init();
+        for (auto &x : rhs)
+            push_back(x);
+    }
+
+    UnrolledList &operator=(const UnrolledList &rhs)
+    {
+        UnrolledList copy{rhs};
+        std::swap(*this, copy);
+        return *this;
+    }
+
+    UnrolledList(UnrolledList &&rhs)
+        : theSize{rhs.theSize}, head{rhs.head}, tail{rhs.tail}
+    {
+        rhs.theSize = 0;
+        rhs.head = nullptr;
+        rhs.tail = nullptr;
+    }
+
+    UnrolledList &operator=(UnrolledList &&rhs)
+    {
+        std::swap(theSize, rhs.theSize);
+        std::swap(head, rhs.head);
+        std::swap(tail, rhs.tail);
+
+        return *this;
+    }
+
+    iterator begin()
+    {
+        return iterator(head->next, 0);
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(head->next, 0);
+    }
+
+    iterator end()
+    {
+        return iterator(tail, 0);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(tail, 0);
+    }
+
+    int size() const
+    {
+        return theSize;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    // Elements per node.
+    static int nodeCapacity()
+    {
+        return NODE_CAPACITY;
+    }
+
+    void clear()
+    {
+        for (Node *p = head->next; p != tail; )
+        {
+            Node *next = p->next;
+            destroy(p->elements(), p->count);
+            delete p;
+            p = next;
+        }
+        head->next = tail;
+        tail->prev = head;
+        theSize = 0;
+    }
+
+    Object &front()
+    {
+        return *begin();
+    }
+
+    const Object &front() const
+    {
+        return *begin();
+    }
+
+    Object &back()
+    {
+        return *--end();
+    }
+
+    const Object &back() const
+    {
+        return *--end();
+    }
+
+    void push_front(const Object &x)
+    {
+        insert(begin(), x);
+    }
+
+    void push_back(const Object &x)
+    {
+        insert(end(), x);
+    }
+
+    void push_front(Object &&x)
+    {
+        insert(begin(), std::move(x));
+    }
+
+    void push_back(Object &&x)
+    {
+        insert(end(), std::move(x));
+    }
+
+    void pop_front()
+    {
+        erase(begin());
+    }
+
+    void pop_back()
+    {
+        erase(--end());
+    }
+
+    iterator insert(iterator itr, const Object &x)
+    {
+        Object copy(x);
+        return insert(itr, std::move(copy));
+    }
+
+    iterator insert(iterator itr, Object &&x)
+    {
+        Node *p = itr.current;
+        int i = itr.index;
+        if (p == tail)
+        {
+            p = tail->prev;
+            i = p->count;
+        }
+
+        if (p == head)
+            p = addNodeAfter(head);
+        else if (p->count == NODE_CAPACITY)
+        {
+            // Appending to a full node starts a new one rather than
+            // splitting, so that elements added in order fill whole nodes.
+            if (i == NODE_CAPACITY)
+            {
+                p = addNodeAfter(p);
+                i = 0;
+            }
+            else if (i == 0 && p->prev != head && p->prev->count < NODE_CAPACITY)
+            {
+                p = p->prev;
+                i = p->count;
+            }
+            else if (i == 0)
+                p = addNodeAfter(p->prev);
+            else
+            {
+                split(p);
+                if (i > p->count)
+                {
+                    i -= p->count;
+                    p = p->next;
+                }
+            }
+        }
+
+        Object *elements = p->elements();
+        if (i == p->count)
+            new (elements + i) Object(std::move(x));
+        else
+        {
+            new (elements + p->count) Object(std::move(elements[p->count - 1]));
+            std::move_backward(elements + i, elements + p->count - 1, elements + p->count);
+            elements[i] = std::move(x);
+        }
+        ++p->count;
+        ++theSize;
+        return iterator(p, i);
+    }
+
+    iterator erase(iterator itr)
+    {
+        Node *p = itr.current;
+        int i = itr.index;
+        Object *elements = p->elements();
+        std::move(elements + i + 1, elements + p->count, elements + i);
+        elements[--p->count].~Object();
+        --theSize;
+
+        if (p->count == 0)
+        {
+            Node *next = p->next;
+            removeNode(p);
+            return iterator(next, 0);
+        }
+        if (p->count < NODE_CAPACITY / 2 && p->next != tail
+            && p->count + p->next->count <= NODE_CAPACITY)
+            merge(p);
+        return i < p->count ? iterator(p, i) : iterator(p->next, 0);
+    }
+
+    // Erases by count, since erasing may move the element at to.
+    iterator erase(iterator from, iterator to) {
+        int count = 0;
+        for (iterator itr = from; itr != to; ++itr)
+            ++count;
+        for (; count > 0; --count)
+            from = erase(from);
+        return from;
+    }
+
+private:
+    int theSize;
+    Node *head;
+    Node *tail;
+
+    void init()
+    {
+        theSize = 0;
+        head = new Node;
+        tail = new Node;
+        head->next = tail;
+        tail->prev = head;
+    }
+
+    Node *addNodeAfter(Node *p)
+    {
+        Node *n = new Node(p, p->next);
+        p->next->prev = n;
+        p->next = n;
+        return n;
+    }
+
+    void removeNode(Node *p)
+    {
+        p->prev->next = p->next;
+        p->next->prev = p->prev;
+        delete p;
+    }
+
+    // Moves the upper half of p's elements to a new node after it.
+    void split(Node *p)
+    {
+        Node *n = addNodeAfter(p);
+        int keep = p->count / 2;
+        relocate(n->elements(), p->elements() + keep, p->count - keep);
+        n->count = p->count - keep;
+        p->count = keep;
+    }
+
+    // Moves all of p->next's elements to the end of p and removes it.
+    void merge(Node *p)
+    {
+        Node *n = p->next;
+        relocate(p->elements() + p->count, n->elements(), n->count);
+        p->count += n->count;
+        removeNode(n);
+    }
+
+    // Moves count elements to uninitialized storage, destroying the old.
+    static void relocate(Object *to, Object *from, int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            new (to + i) Object(std::move(from[i]));
+            from[i].~Object();
+        }
+    }
+
+    static void destroy(Object *first, int count)
+    {
+        for (int i = 0; i < count; ++i)
+            first[i].~Object();
+    }
+};
+
+#endif
@@ -0,0 +1,179 @@
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// Allocators hand Vector raw storage aligned to align, the alignment of its
+// element type, which exceeds alignof(std::max_align_t) only for
+// over-aligned elements:
+//
+//     void *allocate(size_t bytes, size_t align);
+//     void deallocate(void *p, size_t bytes, size_t align);
+//     void *reallocate(void *p, size_t oldBytes, size_t newBytes, size_t align);
+//
+// allocate and reallocate throw std::bad_alloc on failure. reallocate
+// moves the first oldBytes to the new block, which it may extend in place.
+// Allocators may have state; Vector copies them with itself.
+
+// The C heap. realloc can extend a block in place or remap its pages.
+// Over-aligned blocks come from the aligned operator new instead, which
+// has no realloc, so they are always copied to grow.
+struct MallocAllocator
+{
+    void *allocate(size_t bytes, size_t align)
+    {
+#ifdef __cpp_aligned_new
+        if (align > alignof(std::max_align_t))
+            return ::operator new(bytes, std::align_val_t{align});
+#endif
+        void *p = std::malloc(bytes);
+        if (p == nullptr)
+            throw std::bad_alloc{};
+        return p;
+    }
+
+    void deallocate(void *p, size_t, size_t align)
+    {
+#ifdef __cpp_aligned_new
+        if (align > alignof(std::max_align_t))
+        {
+            ::operator delete(p, std::align_val_t{align});
+            return;
+        }
+#endif
+        std::free(p);
+    }
+
+    void *reallocate(void *p, size_t oldBytes, size_t newBytes, size_t align)
+    {
+        if (align > alignof(std::max_align_t))
+        {
+            void *q = allocate(newBytes, align);
+            std::memcpy(q, p, std::min(oldBytes, newBytes));
+            deallocate(p, oldBytes, align);
+            return q;
+        }
+
+        void *q = std::realloc(p, newBytes);
+        if (q == nullptr)
+            throw std::bad_alloc{};
+        return q;
+    }
+};
+
+// A fixed buffer handed out by bumping a pointer. Only the most recent
+// block can be freed or grown in place; everything else is reclaimed at
+// once by reset() or when the arena is destroyed.
+class Arena
+{
+public:
+    explicit Arena(size_t bytes)
+        : begin{static_cast<char *>(std::malloc(bytes))}, top{begin}, end{begin + bytes}
+    {
+        if (begin == nullptr)
+            throw std::bad_alloc{};
+    }
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    ~Arena()
+    {
+        std::free(begin);
+    }
+
+    void *allocate(size_t bytes, size_t align = alignof(std::max_align_t))
+    {
+        size_t skip = padding(top, align);
+        bytes = roundUp(bytes);
+        size_t room = end - top;
+        if (skip > room || bytes > room - skip)
+            throw std::bad_alloc{};
+        char *p = top + skip;
+        top = p + bytes;
+        return p;
+    }
+
+    void deallocate(void *p, size_t bytes)
+    {
+        if (static_cast<char *>(p) + roundUp(bytes) == top)
+            top = static_cast<char *>(p);
+    }
+
+    void *reallocate(void *p, size_t oldBytes, size_t newBytes, size_t align = alignof(std::max_align_t))
+    {
+        char *block = static_cast<char *>(p);
+        if (block + roundUp(oldBytes) == top && roundUp(newBytes) <= static_cast<size_t>(end - block))
+        {
+            top = block + roundUp(newBytes);
+            return p;
+        }
+
+        void *q = allocate(newBytes, align);
+        std::memcpy(q, p, oldBytes < newBytes ? oldBytes : newBytes);
+        return q;
+    }
+
+    void reset()
+    {
+        top = begin;
+    }
+
+    size_t used() const
+    {
+        return top - begin;
+    }
+
+private:
+    char *begin;
+    char *top;
+    char *end;
+
+    static size_t roundUp(size_t bytes)
+    {
+        const size_t align = alignof(std::max_align_t);
+        return (bytes + align - 1) / align * align;
+    }
+
+    // Bytes to skip so that p is aligned to align. Blocks are rounded to
+    // alignof(std::max_align_t), so only over-aligned requests skip any.
+    static size_t padding(const char *p, size_t align)
+    {
+        uintptr_t address = reinterpret_cast<uintptr_t>(p);
+        return (align - address % align) % align;
+    }
+};
+
+// Allocates from an Arena that outlives every Vector using it.
+class ArenaAllocator
+{
+public:
+    explicit ArenaAllocator(Arena &a) : arena{&a}
+    {
+    }
+
+    void *allocate(size_t bytes, size_t align)
+    {
+        return arena->allocate(bytes, align);
+    }
+
+    void deallocate(void *p, size_t bytes, size_t)
+    {
+        arena->deallocate(p, bytes);
+    }
+
+    void *reallocate(void *p, size_t oldBytes, size_t newBytes, size_t align)
+    {
+        return arena->reallocate(p, oldBytes, newBytes, align);
+    }
+
+private:
+    Arena *arena;
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef GROWTH_POLICY_H
+#define GROWTH_POLICY_H
+
+#include <cstddef>
+#include <algorithm>
+
+// Growth policies decide how far a Vector grows when it runs out of room:
+// grow() returns the new capacity for a vector of the given capacity that
+// needs room for at least required elements of objectSize bytes.
+
+// Doubles the capacity, as Vector always did.
+struct DoublingGrowth
+{
+    static int grow(int capacity, int required, size_t)
+    {
+        return std::max(required, 2 * capacity + 1);
+    }
+};
+
+// Grows by half. Uses less memory than doubling, and freed blocks can be
+// reused for later growth since their sizes add up to the next request.
+struct HalfGrowth
+{
+    static int grow(int capacity, int required, size_t)
+    {
+        return std::max(required, capacity + capacity / 2 + 1);
+    }
+};
+
+// Doubles small buffers; a buffer that would reach LARGE_BYTES grows by
+// half instead and is rounded up to whole pages, so that a large buffer is
+// exactly the pages the allocator maps for it and realloc can move it by
+// remapping them.
+struct PageAlignedGrowth
+{
+    enum {PAGE_BYTES = 4096, LARGE_BYTES = 64 * 1024};
+
+    static int grow(int capacity, int required, size_t objectSize)
+    {
+        size_t bytes = static_cast<size_t>(capacity) * objectSize;
+        if (bytes < LARGE_BYTES)
+        {
+            int doubled = DoublingGrowth::grow(capacity, required, objectSize);
+            if (static_cast<size_t>(doubled) * objectSize < LARGE_BYTES)
+                return doubled;
+        }
+
+        size_t wanted = std::max(static_cast<size_t>(required) * objectSize, bytes + bytes / 2);
+        wanted = (wanted + PAGE_BYTES - 1) / PAGE_BYTES * PAGE_BYTES;
+        return static_cast<int>(wanted / objectSize);
+    }
+};
+
+#endif
@@ -2,24 +2,123 @@
 #define VECTOR_H
 
 #include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <new>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "Allocator.h"
+#include "GrowthPolicy.h"
 
+// operator[] checks its index unless NDEBUG is defined, so release builds
+// index with no branch and loops over a Vector can be vectorized. Define
+// VECTOR_CHECK_BOUNDS as 0 or 1 to choose explicitly; at() always checks.
+#ifndef VECTOR_CHECK_BOUNDS
+#ifdef NDEBUG
+#define VECTOR_CHECK_BOUNDS 0
+#else
+#define VECTOR_CHECK_BOUNDS 1
+#endif
+#endif
+
+// Types whose objects can be moved to a new address by copying their bytes,
+// with the old bytes then simply dropped. Vector relocates such elements
+// with realloc instead of moving them one by one. Specialize for types
+// that qualify without being trivially copyable.
 template <typename Object>
-class Vector
+struct IsTriviallyRelocatable : std::is_trivially_copyable<Object> {};
+
+// Raw room for Count objects inside the vector itself.
+template <typename Object, int Count>
+struct InlineStorage
 {
+    Object *data() const
+    {
+        return reinterpret_cast<Object *>(const_cast<unsigned char *>(storage));
+    }
+
+    alignas(Object) unsigned char storage[Count * sizeof(Object)];
+};
+
+template <typename Object>
+struct InlineStorage<Object, 0>
+{
+    Object *data() const
+    {
+        return nullptr;
+    }
+};
+
+// Elements live in raw storage from Allocator and only [objects, finish)
+// hold constructed objects. The first InlineCapacity elements are kept
+// inside the vector and need no allocation; see SmallVector. Both the
+// allocator and the inline storage are bases so that they take no space
+// when empty. The bounds are pointers rather than counts so that a store
+// to an element cannot alias them, which would stop loops over a
+// Vector<int> from being vectorized.
+template <typename Object, typename GrowthPolicy = DoublingGrowth,
+          typename Allocator = MallocAllocator, int InlineCapacity = 0>
+class Vector : private Allocator, private InlineStorage<Object, InlineCapacity>
+{
+#ifndef __cpp_aligned_new
+    static_assert(alignof(Object) <= alignof(std::max_align_t),
+                  "over-aligned elements need C++17 aligned new");
+#endif
+
 public:
-    explicit Vector(int initSize = 0)
-        : theSize{initSize}, theCapacity{initSize + SPARE_CAPACITY}
+    typedef Object * iterator;
+    typedef const Object * const_iterator;
+
+    explicit Vector(int initSize = 0, const Allocator &alloc = Allocator{})
+        : Allocator(alloc)
+    {
+        resetStorage();
+        if (initSize > InlineCapacity)
+            setStorage(allocate(initSize + SPARE_CAPACITY), 0, initSize + SPARE_CAPACITY);
+        try
+        {
+            constructUpTo(initSize);
+        }
+        catch (...)
+        {
+            destroyFrom(0);
+            release();
+            throw;
+        }
+    }
+
+    explicit Vector(const Allocator &alloc)
+        : Vector(0, alloc)
     {
-        objects = new Object[theCapacity]();
     }
 
     Vector(const Vector &rhs)
-        : theSize{rhs.theSize}, theCapacity{rhs.theCapacity}
+        : Allocator(rhs)
     {
-        objects = new Object[theCapacity];
-        for (int i = 0; i < theSize; ++i)
-            objects[i] = rhs.objects[i];
+        resetStorage();
+        if (rhs.size() > InlineCapacity)
+            setStorage(allocate(rhs.capacity()), 0, rhs.capacity());
+        if (std::is_trivially_copyable<Object>::value)
+        {
+            copyBytes(objects, rhs.objects, rhs.size());
+            finish = objects + rhs.size();
+            return;
+        }
+
+        try
+        {
+            for (const Object &x : rhs)
+                new (finish++) Object(x);
+        }
+        catch (...)
+        {
+            --finish;
+            destroyFrom(0);
+            release();
+            throw;
+        }
     }
 
     Vector &operator=(const Vector &rhs)
@@ -31,22 +130,27 @@ public:
 
     ~Vector()
     {
-        delete[] objects;
+        destroyFrom(0);
+        release();
     }
 
     Vector(Vector&& rhs)
-        : theSize{rhs.theSize}, theCapacity{rhs.theCapacity}, objects{rhs.objects}
+        : Allocator(std::move(rhs.allocator()))
     {
-        rhs.theSize = 0;
-        rhs.theCapacity = 0;
-        rhs.objects = nullptr;
+        resetStorage();
+        take(rhs);
     }
 
     Vector &operator=(Vector&& rhs)
     {
-        std::swap(theSize, rhs.theSize);
-        std::swap(theCapacity, rhs.theCapacity);
-        std::swap(objects, rhs.objects);
+        if (this != &rhs)
+        {
+            destroyFrom(0);
+            release();
+            allocator() = std::move(rhs.allocator());
+            resetStorage();
+            take(rhs);
+        }
         return *this;
     }
 
@@ -57,79 +161,132 @@ public:
 
     int size() const
     {
-        return theSize;
+        return finish - objects;
     }
 
     int capacity() const
     {
-        return theCapacity;
+        return storageEnd - objects;
     }
 
     Object &operator[](int index)
     {
-        if (index < 0 || index >= size())
-            throw std::out_of_range{"index less than 0 or greater than the size"};
+        if (VECTOR_CHECK_BOUNDS)
+            checkIndex(index);
         return objects[index];
     }
 
     const Object &operator[](int index) const
     {
-        if (index < 0 || index >= size())
-            throw std::out_of_range{"index less than 0 or greater than the size"};
+        if (VECTOR_CHECK_BOUNDS)
+            checkIndex(index);
+        return objects[index];
+    }
+
+    Object &at(int index)
+    {
+        checkIndex(index);
+        return objects[index];
+    }
+
+    const Object &at(int index) const
+    {
+        checkIndex(index);
         return objects[index];
     }
 
+    // New elements are value-initialized.
     void resize(int newSize)
     {
-        if (newSize > theCapacity)
-            reserve(newSize * 2);
-        theSize = newSize;
+        if (newSize > capacity())
+            grow(newSize);
+        if (newSize > size())
+            constructUpTo(newSize);
+        else
+            destroyFrom(newSize);
     }
 
     void reserve(int newCapacity)
     {
-        if (newCapacity <= theCapacity)
+        if (newCapacity <= capacity())
             return;
 
-        Object *newObjects = new Object[newCapacity]();
-        for (int i = 0; i < theSize; ++i)
-            newObjects[i] = std::move(objects[i]);
+        relocate(newCapacity, std::integral_constant<bool, IsTriviallyRelocatable<Object>::value>{});
+    }
 
-        theCapacity = newCapacity;
-        std::swap(objects, newObjects);
-        delete[] newObjects;
+    template <typename... Args>
+    Object &emplace_back(Args&&... args)
+    {
+        if (finish == storageEnd)
+        {
+            // args may refer to an element of this vector, which growing
+            // relocates.
+            Object x(std::forward<Args>(args)...);
+            grow(size() + 1);
+            new (finish) Object(std::move(x));
+        }
+        else
+            new (finish) Object(std::forward<Args>(args)...);
+        return *finish++;
     }
 
     void push_back(const Object &x)
     {
-        if (theSize == theCapacity)
-            reserve(2 * theCapacity + 1);
-        objects[theSize++] = x;
+        emplace_back(x);
+    }
+
+    void push_back(Object &&x)
+    {
+        emplace_back(std::move(x));
     }
 
-    void push_back(const Object &&x)
+    // Adds the elements of [first, last), which must not be in this vector.
+    // Forward ranges are counted first so that the vector grows at most once.
+    template <typename InputIterator>
+    void append(InputIterator first, InputIterator last)
     {
-        if (theSize == theCapacity)
-            reserve(2 * theCapacity + 1);
-        objects[theSize++] = std::move(x);
+        append(first, last, typename std::iterator_traits<InputIterator>::iterator_category{});
+    }
+
+    // Inserts the elements of [first, last), which must not be in this
+    // vector, before pos. Returns an iterator to the first one inserted.
+    template <typename InputIterator>
+    iterator insert(const_iterator pos, InputIterator first, InputIterator last)
+    {
+        int index = pos - objects;
+        if (index < 0 || index > size())
+            throw std::out_of_range{"insert position outside the vector"};
+
+        int oldSize = size();
+        append(first, last);
+        std::rotate(objects + index, objects + oldSize, finish);
+        return objects + index;
     }
 
     void pop_back()
     {
         if (empty())
             throw std::runtime_error{"pop empty vector"};
-        --theSize;
+        (--finish)->~Object();
     }
 
     const Object &back() const
     {
         if (empty())
             throw std::runtime_error{"empty vector"};
-        return objects[theSize - 1];
+        return finish[-1];
     }
 
-    typedef Object * iterator;
-    typedef const Object * const_iterator;
+    // True while the elements are in the inline storage.
+    bool isInline() const
+    {
+        return objects == inlineObjects();
+    }
+
+    const Allocator &getAllocator() const
+    {
+        return *this;
+    }
 
     iterator begin()
     {
@@ -143,20 +300,185 @@ public:
 
     iterator end()
     {
-        return objects + theSize;
+        return finish;
     }
 
     const_iterator end() const
     {
-        return objects + theSize;
+        return finish;
     }
 
     static const int SPARE_CAPACITY = 2;
 
 private:
-    int theSize;
-    int theCapacity;
     Object *objects;
+    Object *finish;
+    Object *storageEnd;
+
+    Allocator &allocator()
+    {
+        return *this;
+    }
+
+    Object *inlineObjects() const
+    {
+        return InlineStorage<Object, InlineCapacity>::data();
+    }
+
+    void setStorage(Object *newObjects, int size, int capacity)
+    {
+        objects = newObjects;
+        finish = newObjects + size;
+        storageEnd = newObjects + capacity;
+    }
+
+    // Points the vector at its empty inline storage.
+    void resetStorage()
+    {
+        setStorage(inlineObjects(), 0, InlineCapacity);
+    }
+
+    static size_t bytes(int capacity)
+    {
+        return static_cast<size_t>(capacity) * sizeof(Object);
+    }
+
+    void checkIndex(int index) const
+    {
+        if (index < 0 || index >= size())
+            throw std::out_of_range{"index less than 0 or greater than the size"};
+    }
+
+    void grow(int required)
+    {
+        reserve(GrowthPolicy::grow(capacity(), required, sizeof(Object)));
+    }
+
+    template <typename InputIterator>
+    void append(InputIterator first, InputIterator last, std::input_iterator_tag)
+    {
+        for (; first != last; ++first)
+            emplace_back(*first);
+    }
+
+    template <typename ForwardIterator>
+    void append(ForwardIterator first, ForwardIterator last, std::forward_iterator_tag)
+    {
+        int required = size() + static_cast<int>(std::distance(first, last));
+        if (required > capacity())
+            grow(required);
+        for (; first != last; ++first, ++finish)
+            new (finish) Object(*first);
+    }
+
+    Object *allocate(int capacity)
+    {
+        return static_cast<Object *>(allocator().allocate(bytes(capacity), alignof(Object)));
+    }
+
+    // Frees the heap storage, if any; the elements must be destroyed.
+    void release()
+    {
+        if (!isInline())
+            allocator().deallocate(objects, bytes(capacity()), alignof(Object));
+    }
+
+    // Takes over the elements of rhs, which is left empty. Heap storage is
+    // simply handed over; inline elements have to be moved one by one.
+    void take(Vector &rhs)
+    {
+        if (!rhs.isInline())
+        {
+            setStorage(rhs.objects, rhs.size(), rhs.capacity());
+            rhs.resetStorage();
+        }
+        else if (IsTriviallyRelocatable<Object>::value)
+        {
+            copyBytes(objects, rhs.objects, rhs.size());
+            finish = objects + rhs.size();
+            rhs.finish = rhs.objects;
+        }
+        else
+        {
+            for (Object &x : rhs)
+                new (finish++) Object(std::move(x));
+            rhs.destroyFrom(0);
+        }
+    }
+
+    // Moves the elements by realloc. Large blocks are grown by remapping
+    // their pages where the allocator supports it (glibc does through
+    // mremap), so no bytes are copied at all.
+    void relocate(int newCapacity, std::true_type)
+    {
+        int oldSize = size();
+        if (isInline())
+        {
+            Object *newObjects = allocate(newCapacity);
+            copyBytes(newObjects, objects, oldSize);
+            setStorage(newObjects, oldSize, newCapacity);
+        }
+        else
+            setStorage(static_cast<Object *>(allocator().reallocate(objects, bytes(capacity()), bytes(newCapacity),
+                                                                    alignof(Object))),
+                       oldSize, newCapacity);
+    }
+
+    void relocate(int newCapacity, std::false_type)
+    {
+        Object *newObjects = allocate(newCapacity);
+        int moved = 0;
+        try
+        {
+            for (; moved < size(); ++moved)
+                new (newObjects + moved) Object(std::move_if_noexcept(objects[moved]));
+        }
+        catch (...)
+        {
+            destroy(newObjects, moved);
+            allocator().deallocate(newObjects, bytes(newCapacity), alignof(Object));
+            throw;
+        }
+
+        destroy(objects, moved);
+        release();
+        setStorage(newObjects, moved, newCapacity);
+    }
+
+    static void copyBytes(Object *to, const Object *from, int count)
+    {
+        if (count > 0)
+            std::memcpy(static_cast<void *>(to), from, bytes(count));
+    }
+
+    static void destroy(Object *first, int count)
+    {
+        if (!std::is_trivially_destructible<Object>::value)
+            for (int i = 0; i < count; ++i)
+                first[i].~Object();
+    }
+
+    void constructUpTo(int newSize)
+    {
+        for (Object *last = objects + newSize; finish < last; ++finish)
+            new (finish) Object();
+    }
+
+    void destroyFrom(int newSize)
+    {
+        if (newSize < size())
+        {
+            destroy(objects + newSize, size() - newSize);
+            finish = objects + newSize;
+        }
+    }
 };
 
+// A Vector holding up to N elements inline before spilling to the heap, so
+// that small vectors cost no allocation at all. Moving one that is still
+// inline moves its elements rather than a pointer.
+template <typename Object, int N, typename GrowthPolicy = DoublingGrowth,
+          typename Allocator = MallocAllocator>
+using SmallVector = Vector<Object, GrowthPolicy, Allocator, N>;
+
 #endif
@@ -0,0 +1,403 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+// Minimal benchmark harness in the spirit of Google Benchmark. Every
+// benchmark runs in a forked child so that its peak RSS is its own; the
+// child times the region between Timer::start and Timer::stop, counts
+// cache misses over the same region when perf events are available, and
+// reports back through a pipe. Results are printed as a table and can be
+// written as JSON with --json=<file>.
+//
+// Options: --size=<n> (elements per benchmark), --filter=<substring>,
+// --repetitions=<n> (the fastest run is reported), --json=<file>.
+
+namespace bench
+{
+
+template <typename T>
+inline void doNotOptimize(const T &value)
+{
+#if defined(__GNUC__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const T *sink;
+    sink = &value;
+#endif
+}
+
+// Counts last-level cache misses of this process in user space; reads
+// -1 when the kernel does not allow perf events.
+class CacheMissCounter
+{
+public:
+    CacheMissCounter() : fd{-1}
+    {
+#ifdef __linux__
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    ~CacheMissCounter()
+    {
+        if (fd != -1)
+            close(fd);
+    }
+
+    CacheMissCounter(const CacheMissCounter &) = delete;
+    CacheMissCounter &operator=(const CacheMissCounter &) = delete;
+
+    void start()
+    {
+#ifdef __linux__
+        if (fd != -1)
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    void stop()
+    {
+#ifdef __linux__
+        if (fd != -1)
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+#endif
+    }
+
+    int64_t read() const
+    {
+        int64_t count;
+        if (fd == -1 || ::read(fd, &count, sizeof(count)) != sizeof(count))
+            return -1;
+        return count;
+    }
+
+private:
+    int fd;
+};
+
+// Handed to each benchmark body; only the code between start() and stop()
+// is measured. Both may be called repeatedly to exclude setup steps.
+class Timer
+{
+public:
+    void start()
+    {
+        misses.start();
+        begin = std::chrono::steady_clock::now();
+    }
+
+    void stop()
+    {
+        elapsed += std::chrono::steady_clock::now() - begin;
+        misses.stop();
+    }
+
+    double nanoseconds() const
+    {
+        return std::chrono::duration<double, std::nano>(elapsed).count();
+    }
+
+    int64_t cacheMisses() const
+    {
+        return misses.read();
+    }
+
+private:
+    std::chrono::steady_clock::time_point begin;
+    std::chrono::steady_clock::duration elapsed{0};
+    CacheMissCounter misses;
+};
+
+struct Result
+{
+    std::string name;
+    long ops;
+    double nsPerOp;
+    double missesPerOp;     // negative when unavailable
+    long peakRssKb;
+};
+
+class Runner
+{
+public:
+    Runner(int argc, char **argv) : size{1000000}, repetitions{1}
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg.compare(0, 7, "--size=") == 0)
+                size = std::atol(arg.c_str() + 7);
+            else if (arg.compare(0, 9, "--filter=") == 0)
+                filter = arg.substr(9);
+            else if (arg.compare(0, 14, "--repetitions=") == 0)
+                repetitions = std::max(1, std::atoi(arg.c_str() + 14));
+            else if (arg.compare(0, 7, "--json=") == 0)
+                jsonPath = arg.substr(7);
+            else
+            {
+                std::cerr << "usage: " << argv[0]
+                          << " [--size=n] [--filter=s] [--repetitions=n] [--json=file]" << std::endl;
+                std::exit(1);
+            }
+        }
+        std::printf("%-48s %12s %14s %12s %12s\n", "Benchmark", "Ops", "ns/op", "misses/op", "peak RSS kB");
+    }
+
+    ~Runner()
+    {
+        if (!jsonPath.empty())
+            writeJson();
+    }
+
+    long elements() const
+    {
+        return size;
+    }
+
+    // Runs body(timer) in a child process and records ops operations.
+    void run(const std::string &name, long ops, const std::function<void(Timer &)> &body)
+    {
+        if (name.find(filter) == std::string::npos)
+            return;
+
+        Result best{name, ops, 0, -1, 0};
+        for (int rep = 0; rep < repetitions; ++rep)
+        {
+            Result r = runChild(name, ops, body);
+            if (rep == 0 || (r.nsPerOp >= 0 && (best.nsPerOp < 0 || r.nsPerOp < best.nsPerOp)))
+                best = r;
+        }
+
+        if (best.nsPerOp < 0)
+            std::printf("%-48s %12s\n", name.c_str(), "FAILED");
+        else if (best.missesPerOp < 0)
+            std::printf("%-48s %12ld %14.2f %12s %12ld\n", name.c_str(), ops, best.nsPerOp, "n/a", best.peakRssKb);
+        else
+            std::printf("%-48s %12ld %14.2f %12.3f %12ld\n", name.c_str(), ops, best.nsPerOp, best.missesPerOp, best.peakRssKb);
+        std::fflush(stdout);
+        results.push_back(best);
+    }
+
+private:
+    long size;
+    int repetitions;
+    std::string filter;
+    std::string jsonPath;
+    std::vector<Result> results;
+
+    struct Report
+    {
+        double nanoseconds;
+        int64_t misses;
+        long peakRssKb;
+    };
+
+    static Result runChild(const std::string &name, long ops, const std::function<void(Timer &)> &body)
+    {
+        Result result{name, ops, -1, -1, 0};
+        int fds[2];
+        if (pipe(fds) == -1)
+            return result;
+
+        std::fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            close(fds[0]);
+            Timer timer;
+            body(timer);
+
+            rusage usage;
+            getrusage(RUSAGE_SELF, &usage);
+            Report report{timer.nanoseconds(), timer.cacheMisses(), usage.ru_maxrss};
+            ssize_t written = write(fds[1], &report, sizeof(report));
+            _exit(written == sizeof(report) ? 0 : 1);
+        }
+
+        close(fds[1]);
+        Report report;
+        bool ok = pid > 0 && ::read(fds[0], &report, sizeof(report)) == sizeof(report);
+        close(fds[0]);
+        if (pid > 0)
+            waitpid(pid, nullptr, 0);
+        if (!ok)
+            return result;
+
+        result.nsPerOp = report.nanoseconds / std::max(ops, 1L);
+        result.missesPerOp = report.misses < 0 ? -1 : static_cast<double>(report.misses) / std::max(ops, 1L);
+        result.peakRssKb = report.peakRssKb;
+        return result;
+    }
+
+    void writeJson() const
+    {
+        std::ofstream out{jsonPath};
+        out << "{\n  \"context\": {\n"
+            << "    \"executable\": \"" << jsonEscape(executableName()) << "\",\n"
+            << "    \"size\": " << size << ",\n"
+            << "    \"repetitions\": " << repetitions << ",\n"
+            << "    \"num_cpus\": " << sysconf(_SC_NPROCESSORS_ONLN) << "\n"
+            << "  },\n  \"benchmarks\": [";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const Result &r = results[i];
+            out << (i == 0 ? "\n" : ",\n")
+                << "    {\"name\": \"" << jsonEscape(r.name) << "\", \"iterations\": " << r.ops
+                << ", \"real_time\": " << r.nsPerOp << ", \"time_unit\": \"ns\""
+                << ", \"cache_misses_per_op\": ";
+            if (r.missesPerOp < 0)
+                out << "null";
+            else
+                out << r.missesPerOp;
+            out << ", \"peak_rss_kb\": " << r.peakRssKb << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    static std::string executableName()
+    {
+        char path[4096];
+        ssize_t n = readlink("/proc/self/exe", path, sizeof(path) - 1);
+        return n > 0 ? std::string(path, n) : std::string();
+    }
+
+    static std::string jsonEscape(const std::string &s)
+    {
+        std::string escaped;
+        for (char c : s)
+        {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+};
+
+// Key distributions. Each returns n keys; Distribution names are used as
+// the last component of benchmark names.
+enum Distribution {UNIFORM, ZIPF, SORTED, ADVERSARIAL};
+
+const Distribution ALL_DISTRIBUTIONS[] = {UNIFORM, ZIPF, SORTED, ADVERSARIAL};
+
+inline const char *distributionName(Distribution d)
+{
+    switch (d)
+    {
+    case UNIFORM:
+        return "uniform";
+    case ZIPF:
+        return "zipf";
+    case SORTED:
+        return "sorted";
+    default:
+        return "adversarial";
+    }
+}
+
+// Zipf with exponent 0.99 over n ranks, sampled by inverting the CDF;
+// ranks are scattered over the key space so popular keys are not adjacent.
+inline std::vector<int> zipfKeys(long n, std::mt19937_64 &generator)
+{
+    std::vector<double> cdf(n);
+    double sum = 0;
+    for (long i = 0; i < n; ++i)
+        cdf[i] = sum += 1.0 / std::pow(i + 1.0, 0.99);
+
+    std::uniform_real_distribution<double> unit(0, sum);
+    std::vector<int> keys(n);
+    for (auto &key : keys)
+    {
+        long rank = std::lower_bound(cdf.begin(), cdf.end(), unit(generator)) - cdf.begin();
+        key = static_cast<int>((static_cast<uint64_t>(rank) * UINT64_C(2654435761)) & 0x7FFFFFFF);
+    }
+    return keys;
+}
+
+// UNIFORM draws from the whole non-negative int range; SORTED is 0..n-1
+// ascending, the worst case for unbalanced trees; ADVERSARIAL keys are
+// distinct but share as many low zero bits as fit (16 for small n), so
+// they collide under hashing schemes that keep only low bits, and come
+// out in descending order.
+inline std::vector<int> makeKeys(Distribution d, long n, uint64_t seed = 42)
+{
+    std::mt19937_64 generator{seed};
+    std::vector<int> keys(n);
+    switch (d)
+    {
+    case UNIFORM:
+    {
+        std::uniform_int_distribution<int> any(0, 0x7FFFFFFF);
+        for (auto &key : keys)
+            key = any(generator);
+        break;
+    }
+    case ZIPF:
+        keys = zipfKeys(n, generator);
+        break;
+    case SORTED:
+        for (long i = 0; i < n; ++i)
+            keys[i] = static_cast<int>(i);
+        break;
+    case ADVERSARIAL:
+    {
+        int shift = 16;
+        while (shift > 0 && (n << shift) > 0x7FFFFFFF)
+            --shift;
+        for (long i = 0; i < n; ++i)
+            keys[i] = static_cast<int>((n - i) << shift);
+        break;
+    }
+    }
+    return keys;
+}
+
+// Keys guaranteed absent from makeKeys(d, n): every generated key is
+// non-negative.
+inline std::vector<int> missingKeys(long n)
+{
+    std::vector<int> keys(n);
+    std::mt19937_64 generator{7};
+    std::uniform_int_distribution<int> negative(-0x7FFFFFFF, -1);
+    for (auto &key : keys)
+        key = negative(generator);
+    return keys;
+}
+
+inline std::string benchName(const std::string &container, const std::string &op, Distribution d)
+{
+    return container + "/" + op + "/" + distributionName(d);
+}
+
+}
+
+#endif
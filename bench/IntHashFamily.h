@@ -0,0 +1,40 @@
+#ifndef INT_HASH_FAMILY_H
+#define INT_HASH_FAMILY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include "HashUtils.h"
+
+// Seeded integer hash family for the cuckoo tables.
+template <int count>
+class IntHashFamily
+{
+public:
+    IntHashFamily()
+    {
+        generateNewFunctions();
+    }
+
+    int getNumberOfFunctions() const
+    {
+        return count;
+    }
+
+    void generateNewFunctions()
+    {
+        for (auto &seed : seeds)
+            seed = generator();
+    }
+
+    size_t hash(int x, int which) const
+    {
+        return mixHash(static_cast<uint32_t>(x) ^ seeds[which]);
+    }
+
+private:
+    uint64_t seeds[count];
+    std::mt19937_64 generator;
+};
+
+#endif
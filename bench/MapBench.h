@@ -0,0 +1,87 @@
+#ifndef MAP_BENCH_H
+#define MAP_BENCH_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Bench.h"
+
+// Benchmarks for the HashMap variants of the hash tables, which offer
+// operator[], find and tryEmplace. std::unordered_map is adapted by
+// overloads.
+
+namespace bench
+{
+
+template <typename Map>
+const int *mapFind(const Map &m, int key)
+{
+    auto *entry = m.find(key);
+    return entry ? &entry->second : nullptr;
+}
+
+template <typename Map>
+bool mapTryEmplace(Map &m, int key, int value)
+{
+    return m.tryEmplace(key, value).second;
+}
+
+inline const int *mapFind(const std::unordered_map<int, int> &m, int key)
+{
+    auto it = m.find(key);
+    return it == m.end() ? nullptr : &it->second;
+}
+
+inline bool mapTryEmplace(std::unordered_map<int, int> &m, int key, int value)
+{
+    return m.try_emplace(key, value).second;
+}
+
+// Counts zipf-distributed keys with operator[], emplaces uniform keys, and
+// finds the counted keys again.
+template <typename Map>
+void benchMap(Runner &runner, const std::string &name)
+{
+    long n = runner.elements();
+
+    runner.run(name + "/count/zipf", n, [=](Timer &timer)
+    {
+        std::vector<int> keys = makeKeys(ZIPF, n);
+        timer.start();
+        Map m;
+        for (int key : keys)
+            ++m[key];
+        timer.stop();
+    });
+
+    runner.run(name + "/try_emplace/uniform", n, [=](Timer &timer)
+    {
+        std::vector<int> keys = makeKeys(UNIFORM, n);
+        long inserted = 0;
+        timer.start();
+        Map m;
+        for (int key : keys)
+            inserted += mapTryEmplace(m, key, key);
+        timer.stop();
+        doNotOptimize(inserted);
+    });
+
+    runner.run(name + "/find/zipf", n, [=](Timer &timer)
+    {
+        std::vector<int> keys = makeKeys(ZIPF, n);
+        Map m;
+        for (int key : keys)
+            ++m[key];
+
+        long total = 0;
+        timer.start();
+        for (int key : keys)
+            total += *mapFind(m, key);
+        timer.stop();
+        doNotOptimize(total);
+    });
+}
+
+}
+
+#endif
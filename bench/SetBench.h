@@ -0,0 +1,338 @@
+#ifndef SET_BENCH_H
+#define SET_BENCH_H
+
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#include "Bench.h"
+#include "HashStats.h"
+#include "HashUtils.h"
+
+// Benchmarks shared by the trees and hash tables, which all offer insert,
+// contains and remove. The std containers are adapted by overloads.
+
+namespace bench
+{
+
+template <typename Set>
+void setInsert(Set &s, int x)
+{
+    s.insert(x);
+}
+
+template <typename Set>
+bool setContains(const Set &s, int x)
+{
+    return s.contains(x);
+}
+
+template <typename Set>
+void setRemove(Set &s, int x)
+{
+    s.remove(x);
+}
+
+template <typename T>
+bool setContains(const std::set<T> &s, int x)
+{
+    return s.count(x) != 0;
+}
+
+template <typename T>
+void setRemove(std::set<T> &s, int x)
+{
+    s.erase(x);
+}
+
+template <typename T>
+bool setContains(const std::unordered_set<T> &s, int x)
+{
+    return s.count(x) != 0;
+}
+
+template <typename T>
+void setRemove(std::unordered_set<T> &s, int x)
+{
+    s.erase(x);
+}
+
+// Runs insert, lookups drawn from the same distribution, lookups of absent
+// keys, and remove for every key distribution. maxSorted caps the element
+// count for the sorted and adversarial inputs, which degrade unbalanced
+// trees to lists.
+template <typename Set>
+void benchSet(Runner &runner, const std::string &name, long maxSorted = 0)
+{
+    for (Distribution d : ALL_DISTRIBUTIONS)
+    {
+        long n = runner.elements();
+        if (maxSorted > 0 && (d == SORTED || d == ADVERSARIAL))
+            n = std::min(n, maxSorted);
+
+        runner.run(benchName(name, "insert", d), n, [=](Timer &timer)
+        {
+            std::vector<int> keys = makeKeys(d, n);
+            timer.start();
+            Set s;
+            for (int key : keys)
+                setInsert(s, key);
+            timer.stop();
+        });
+
+        runner.run(benchName(name, "contains", d), n, [=](Timer &timer)
+        {
+            std::vector<int> keys = makeKeys(d, n);
+            std::vector<int> lookups = makeKeys(d, n, 1234);
+            Set s;
+            for (int key : keys)
+                setInsert(s, key);
+            // Fresh uniform keys would almost all miss.
+            if (d == UNIFORM)
+                lookups = keys;
+
+            long found = 0;
+            timer.start();
+            for (int key : lookups)
+                found += setContains(s, key);
+            timer.stop();
+            doNotOptimize(found);
+        });
+
+        runner.run(benchName(name, "contains_miss", d), n, [=](Timer &timer)
+        {
+            std::vector<int> keys = makeKeys(d, n);
+            std::vector<int> lookups = missingKeys(n);
+            Set s;
+            for (int key : keys)
+                setInsert(s, key);
+
+            long found = 0;
+            timer.start();
+            for (int key : lookups)
+                found += setContains(s, key);
+            timer.stop();
+            doNotOptimize(found);
+        });
+
+        runner.run(benchName(name, "remove", d), n, [=](Timer &timer)
+        {
+            std::vector<int> keys = makeKeys(d, n);
+            Set s;
+            for (int key : keys)
+                setInsert(s, key);
+
+            timer.start();
+            for (int key : keys)
+                setRemove(s, key);
+            timer.stop();
+        });
+    }
+}
+
+// Compares a loop of contains with containsBatch on the same shuffled mix
+// of hits and misses, and times insertBatch, for the hash tables that
+// prefetch whole batches.
+template <typename Set>
+void benchBatch(Runner &runner, const std::string &name)
+{
+    long n = runner.elements();
+    auto mixedLookups = [](const std::vector<int> &keys)
+    {
+        std::vector<int> lookups = missingKeys(keys.size());
+        std::copy(keys.begin(), keys.begin() + keys.size() / 2, lookups.begin());
+        std::shuffle(lookups.begin(), lookups.end(), std::mt19937_64{99});
+        return lookups;
+    };
+
+    runner.run(name + "/insert_batch", n, [=](Timer &timer)
+    {
+        std::vector<int> keys = makeKeys(UNIFORM, n);
+        timer.start();
+        Set s;
+        s.insertBatch(keys.data(), static_cast<int>(n));
+        timer.stop();
+    });
+
+    runner.run(name + "/contains_mixed", n, [=](Timer &timer)
+    {
+        std::vector<int> keys = makeKeys(UNIFORM, n);
+        std::vector<int> lookups = mixedLookups(keys);
+        Set s;
+        for (int key : keys)
+            s.insert(key);
+
+        long found = 0;
+        timer.start();
+        for (int key : lookups)
+            found += s.contains(key);
+        timer.stop();
+        doNotOptimize(found);
+    });
+
+    runner.run(name + "/contains_batch_mixed", n, [=](Timer &timer)
+    {
+        std::vector<int> keys = makeKeys(UNIFORM, n);
+        std::vector<int> lookups = mixedLookups(keys);
+        Set s;
+        for (int key : keys)
+            s.insert(key);
+        std::unique_ptr<bool[]> out{new bool[n]};
+
+        timer.start();
+        s.containsBatch(lookups.data(), static_cast<int>(n), out.get());
+        timer.stop();
+        doNotOptimize(std::count(out.get(), out.get() + n, true));
+    });
+}
+
+// Looks up string keys held as std::string, std::string_view and C
+// strings, and removes them by view, in a table of std::string. The view
+// and C string lookups go through the tables' transparent overloads
+// without building a std::string.
+template <typename Set>
+void benchTransparent(Runner &runner, const std::string &name)
+{
+    long n = runner.elements();
+    auto makeStrings = [](long count)
+    {
+        std::vector<int> keys = makeKeys(UNIFORM, count);
+        std::vector<std::string> strings(count);
+        for (long i = 0; i < count; ++i)
+            strings[i] = "id" + std::to_string(keys[i]);
+        return strings;
+    };
+
+    runner.run(name + "/contains/string", n, [=](Timer &timer)
+    {
+        std::vector<std::string> strings = makeStrings(n);
+        Set s;
+        for (auto &str : strings)
+            s.insert(str);
+
+        long found = 0;
+        timer.start();
+        for (auto &str : strings)
+            found += s.contains(str);
+        timer.stop();
+        doNotOptimize(found);
+    });
+
+    runner.run(name + "/contains/view", n, [=](Timer &timer)
+    {
+        std::vector<std::string> strings = makeStrings(n);
+        Set s;
+        for (auto &str : strings)
+            s.insert(str);
+        std::vector<std::string_view> views(strings.begin(), strings.end());
+
+        long found = 0;
+        timer.start();
+        for (std::string_view view : views)
+            found += s.contains(view);
+        timer.stop();
+        doNotOptimize(found);
+    });
+
+    runner.run(name + "/contains/cstr", n, [=](Timer &timer)
+    {
+        std::vector<std::string> strings = makeStrings(n);
+        Set s;
+        for (auto &str : strings)
+            s.insert(str);
+
+        long found = 0;
+        timer.start();
+        for (auto &str : strings)
+            found += s.contains(str.c_str());
+        timer.stop();
+        doNotOptimize(found);
+    });
+
+    runner.run(name + "/remove/view", n, [=](Timer &timer)
+    {
+        std::vector<std::string> strings = makeStrings(n);
+        Set s;
+        for (auto &str : strings)
+            s.insert(str);
+        std::vector<std::string_view> views(strings.begin(), strings.end());
+
+        timer.start();
+        for (std::string_view view : views)
+            s.remove(view);
+        timer.stop();
+    });
+}
+
+// For the tables hashed by DefaultHash: hashes each view once up front and
+// looks it up with findWithHash, as a caller probing several tables would.
+template <typename Set>
+void benchFindWithHash(Runner &runner, const std::string &name)
+{
+    long n = runner.elements();
+    runner.run(name + "/find_with_hash/view", n, [=](Timer &timer)
+    {
+        std::vector<int> keys = makeKeys(UNIFORM, n);
+        std::vector<std::string> strings(n);
+        for (long i = 0; i < n; ++i)
+            strings[i] = "id" + std::to_string(keys[i]);
+        Set s;
+        for (auto &str : strings)
+            s.insert(str);
+        std::vector<std::string_view> views(strings.begin(), strings.end());
+        std::vector<size_t> hashVals(n);
+        for (long i = 0; i < n; ++i)
+            hashVals[i] = DefaultHash{}(views[i]);
+
+        long found = 0;
+        timer.start();
+        for (long i = 0; i < n; ++i)
+            found += s.findWithHash(views[i], hashVals[i]);
+        timer.stop();
+        doNotOptimize(found);
+    });
+}
+
+// Builds a table with a counting stats policy, runs n hits, n misses and
+// n / 2 removes against it, and prints its stats() with one row per
+// length of the probe, displacement and chain histograms.
+template <typename Set>
+void reportStats(long n, const std::string &name)
+{
+    std::vector<int> keys = makeKeys(UNIFORM, n);
+    std::vector<int> absent = missingKeys(n);
+    Set s;
+    for (int key : keys)
+        s.insert(key);
+    long found = 0;
+    for (int key : keys)
+        found += s.contains(key);
+    for (int key : absent)
+        found += s.contains(key);
+    for (long i = 0; i < n / 2; ++i)
+        s.remove(keys[i]);
+    doNotOptimize(found);
+
+    HashStats st = s.stats();
+    std::printf("\n%s stats: size %d, capacity %d, load %.3f, tombstones %d, rehashes %llu\n",
+                name.c_str(), st.size, st.capacity, st.loadFactor, st.tombstones,
+                static_cast<unsigned long long>(st.rehashes));
+
+    int last = 0;
+    for (int length = 0; length < HashStats::HISTOGRAM_SIZE; ++length)
+        if (st.probeLengths[length] || st.displacements[length] || st.chainLengths[length])
+            last = length;
+    std::printf("%8s %14s %14s %14s\n", "length", "probes", "displacements", "chains");
+    for (int length = 0; length <= last; ++length)
+        std::printf("%7d%s %14llu %14llu %14llu\n", length,
+                    length == HashStats::HISTOGRAM_SIZE - 1 ? "+" : " ",
+                    static_cast<unsigned long long>(st.probeLengths[length]),
+                    static_cast<unsigned long long>(st.displacements[length]),
+                    static_cast<unsigned long long>(st.chainLengths[length]));
+}
+
+}
+
+#endif
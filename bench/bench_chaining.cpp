@@ -0,0 +1,22 @@
+#include <unordered_set>
+#include "MapBench.h"
+#include "SetBench.h"
+#include "SeparateChainingHashingTable.h"
+#include "ArenaChainingHashingTable.h"
+
+using namespace bench;
+
+int main(int argc, char **argv)
+{
+    Runner runner{argc, argv};
+    benchSet<HashTable<int>>(runner, "SeparateChaining");
+    benchBatch<HashTable<int>>(runner, "SeparateChaining");
+    benchTransparent<HashTable<std::string>>(runner, "SeparateChaining<string>");
+    benchFindWithHash<HashTable<std::string>>(runner, "SeparateChaining<string>");
+    benchSet<HashTable<int, PrimeSizing, true>>(runner, "SeparateChaining<Incremental>");
+    benchSet<ArenaHashTable<int>>(runner, "ArenaChaining");
+    benchSet<std::unordered_set<int>>(runner, "std::unordered_set");
+    benchMap<HashMap<int, int>>(runner, "SeparateChainingMap");
+    benchMap<std::unordered_map<int, int>>(runner, "std::unordered_map");
+    reportStats<HashTable<int, PrimeSizing, false, CountStats>>(runner.elements(), "SeparateChaining");
+}
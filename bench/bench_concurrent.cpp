@@ -0,0 +1,99 @@
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include "Bench.h"
+#include "IntHashFamily.h"
+#include "ConcurrentCuckooHashTable.h"
+#include "ConcurrentHashTable.h"
+#include "QuadraticProbingHashingTable.h"
+
+using namespace bench;
+
+// The table the concurrent ones replace: one HashTable behind one mutex.
+class MutexTable
+{
+public:
+    explicit MutexTable(int size) : table{size}
+    {
+    }
+
+    bool contains(int x)
+    {
+        std::lock_guard<std::mutex> guard{lock};
+        return table.contains(x);
+    }
+
+    bool insert(int x)
+    {
+        std::lock_guard<std::mutex> guard{lock};
+        return table.insert(x);
+    }
+
+    bool remove(int x)
+    {
+        std::lock_guard<std::mutex> guard{lock};
+        return table.remove(x);
+    }
+
+private:
+    std::mutex lock;
+    HashTable<int> table;
+};
+
+// threads share n operations on a table preloaded with every other key of
+// [0, n). Keys are drawn uniformly from that range, so about half the
+// lookups hit; writePercent percent of the operations are inserts and
+// removes in equal parts, and the rest are lookups.
+template <typename Table>
+void benchTable(Runner &runner, const std::string &name)
+{
+    long n = runner.elements();
+
+    for (int writePercent : {10, 50})
+        for (int threads : {1, 2, 4, 8})
+        {
+            std::string workload = writePercent == 10 ? "read_heavy" : "mixed";
+            runner.run(name + "/" + workload + "/" + std::to_string(threads), n, [=](Timer &timer)
+            {
+                std::vector<int> keys = makeKeys(UNIFORM, n);
+                std::vector<int> draws = makeKeys(UNIFORM, n, 77);
+                Table table(static_cast<int>(n));
+                for (long k = 0; k < n; k += 2)
+                    table.insert(static_cast<int>(k));
+
+                std::atomic<long> succeeded{0};
+                std::vector<std::thread> workers;
+
+                timer.start();
+                for (int t = 0; t < threads; ++t)
+                    workers.emplace_back([&, t]
+                    {
+                        long local = 0;
+                        for (long i = t; i < n; i += threads)
+                        {
+                            int key = static_cast<int>(keys[i] % n);
+                            int draw = draws[i] % 100;
+                            if (draw >= writePercent)
+                                local += table.contains(key);
+                            else if (draw % 2 == 0)
+                                local += table.insert(key);
+                            else
+                                local += table.remove(key);
+                        }
+                        succeeded += local;
+                    });
+                for (auto &worker : workers)
+                    worker.join();
+                timer.stop();
+                doNotOptimize(succeeded.load());
+            });
+        }
+}
+
+int main(int argc, char **argv)
+{
+    Runner runner{argc, argv};
+    benchTable<MutexTable>(runner, "HashTable+mutex");
+    benchTable<ConcurrentHashTable<int, HashTable<int>>>(runner, "ConcurrentHashTable");
+    benchTable<ConcurrentCuckooHashTable<int, IntHashFamily<2>>>(runner, "ConcurrentCuckooHashTable");
+}
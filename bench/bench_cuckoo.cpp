@@ -0,0 +1,43 @@
+#include <unordered_set>
+#include "MapBench.h"
+#include "SetBench.h"
+#include "IntHashFamily.h"
+#include "CuckooHashTable.h"
+#include "BucketizedCuckooHashTable.h"
+
+using namespace bench;
+
+// Inserts n uniform keys and prints the highest load the table reached
+// before it had to grow, which bounds the memory it needs per element.
+template <typename Set>
+void reportLoad(long n, const std::string &name)
+{
+    std::vector<int> keys = makeKeys(UNIFORM, n);
+    Set s;
+    double highest = 0;
+    for (int key : keys)
+    {
+        int before = s.capacity();
+        s.insert(key);
+        if (s.capacity() == before)
+            highest = std::max(highest, static_cast<double>(s.size()) / s.capacity());
+    }
+    std::printf("%-48s %14.3f\n", name.c_str(), highest);
+}
+
+int main(int argc, char **argv)
+{
+    Runner runner{argc, argv};
+    benchSet<HashTable<int, IntHashFamily<2>>>(runner, "Cuckoo");
+    benchBatch<HashTable<int, IntHashFamily<2>>>(runner, "Cuckoo");
+    benchTransparent<HashTable<std::string, StringHashFamily<2>>>(runner, "Cuckoo<string>");
+    benchSet<BucketizedCuckooHashTable<int, IntHashFamily<2>>>(runner, "BucketizedCuckoo");
+    benchSet<std::unordered_set<int>>(runner, "std::unordered_set");
+    benchMap<HashMap<int, int, IntHashFamily<2>>>(runner, "CuckooMap");
+    benchMap<std::unordered_map<int, int>>(runner, "std::unordered_map");
+    reportStats<HashTable<int, IntHashFamily<2>, PrimeSizing, CountStats>>(runner.elements(), "Cuckoo");
+
+    std::printf("\n%-48s %14s\n", "Highest load before growing", "load");
+    reportLoad<HashTable<int, IntHashFamily<2>>>(runner.elements(), "Cuckoo");
+    reportLoad<BucketizedCuckooHashTable<int, IntHashFamily<2>>>(runner.elements(), "BucketizedCuckoo");
+}
@@ -0,0 +1,82 @@
+#include <string>
+#include "Bench.h"
+#include "IntHashFamily.h"
+#include "CuckooFilter.h"
+#include "BlockedBloomFilter.h"
+
+using namespace bench;
+
+typedef CuckooFilter<int, IntHashFamily<1>> Cuckoo;
+typedef BlockedBloomFilter<int, IntHashFamily<1>> BlockedBloom;
+
+const double TARGET_RATES[] = {0.01, 0.001, 0.0001};
+
+template <typename Filter>
+void benchFilter(Runner &runner, const std::string &name)
+{
+    long n = runner.elements();
+
+    runner.run(name + "/insert", n, [=](Timer &timer)
+    {
+        std::vector<int> keys = makeKeys(SORTED, n);
+        timer.start();
+        Filter filter(static_cast<int>(n));
+        for (int key : keys)
+            filter.insert(key);
+        timer.stop();
+    });
+
+    for (bool hit : {true, false})
+        runner.run(name + (hit ? "/contains" : "/contains_miss"), n, [=](Timer &timer)
+        {
+            std::vector<int> keys = makeKeys(SORTED, n);
+            std::vector<int> lookups = hit ? keys : missingKeys(n);
+            Filter filter(static_cast<int>(n));
+            for (int key : keys)
+                filter.insert(key);
+            std::shuffle(lookups.begin(), lookups.end(), std::mt19937_64{99});
+
+            long found = 0;
+            timer.start();
+            for (int key : lookups)
+                found += filter.contains(key);
+            timer.stop();
+            doNotOptimize(found);
+        });
+}
+
+// Fills a filter sized for n keys with n keys at each target rate, then
+// prints the rate at which it accepts n absent keys, its bits per key
+// and how many inserted keys it misses, which must be none.
+template <typename Filter>
+void reportAccuracy(long n, const std::string &name)
+{
+    std::vector<int> keys = makeKeys(SORTED, n);
+    std::vector<int> absent = missingKeys(n);
+    for (double target : TARGET_RATES)
+    {
+        Filter filter(static_cast<int>(n), target);
+        for (int key : keys)
+            filter.insert(key);
+
+        long falseNegatives = 0, falsePositives = 0;
+        for (int key : keys)
+            falseNegatives += !filter.contains(key);
+        for (int key : absent)
+            falsePositives += filter.contains(key);
+
+        std::printf("%-32s %7.2f%% %9.3f%% %14.2f %14ld\n", name.c_str(), 100 * target,
+                    100.0 * falsePositives / n, filter.bitsPerKey(), falseNegatives);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Runner runner{argc, argv};
+    benchFilter<Cuckoo>(runner, "CuckooFilter");
+    benchFilter<BlockedBloom>(runner, "BlockedBloomFilter");
+
+    std::printf("\n%-32s %8s %10s %14s %14s\n", "False positives", "target", "measured", "bits/key", "false neg.");
+    reportAccuracy<Cuckoo>(runner.elements(), "CuckooFilter");
+    reportAccuracy<BlockedBloom>(runner.elements(), "BlockedBloomFilter");
+}
@@ -0,0 +1,130 @@
+#include <functional>
+#include <queue>
+#include "Bench.h"
+#include "Heap/BinaryHeap.h"
+
+using namespace bench;
+
+typedef std::priority_queue<int, std::vector<int>, std::greater<int>> StdMinHeap;
+
+template <int Arity>
+inline void heapPush(BinaryHeap<int, Arity> &h, int x)
+{
+    h.insert(x);
+}
+
+inline void heapPush(StdMinHeap &h, int x)
+{
+    h.push(x);
+}
+
+template <typename Heap>
+void benchHeap(Runner &runner, const std::string &name)
+{
+    long n = runner.elements();
+
+    for (Distribution d : ALL_DISTRIBUTIONS)
+    {
+        runner.run(benchName(name, "push", d), n, [=](Timer &timer)
+        {
+            std::vector<int> keys = makeKeys(d, n);
+            timer.start();
+            Heap h;
+            for (int key : keys)
+                heapPush(h, key);
+            timer.stop();
+            doNotOptimize(h.top());
+        });
+
+        runner.run(benchName(name, "pop", d), n, [=](Timer &timer)
+        {
+            std::vector<int> keys = makeKeys(d, n);
+            Heap h;
+            for (int key : keys)
+                heapPush(h, key);
+
+            long sum = 0;
+            timer.start();
+            while (!h.empty())
+            {
+                sum += h.top();
+                h.pop();
+            }
+            timer.stop();
+            doNotOptimize(sum);
+        });
+    }
+}
+
+// Lowers the key of n / 2 random entries and then pops everything, the way
+// Dijkstra's algorithm uses a heap. The addressable heap lowers keys in
+// place; std::priority_queue has to take a duplicate entry and skip the
+// stale one when it is popped.
+void benchDecrease(Runner &runner)
+{
+    long n = runner.elements();
+
+    runner.run("BinaryHeap<4,addressable>/decrease", n, [=](Timer &timer)
+    {
+        std::vector<int> keys = makeKeys(UNIFORM, n);
+        std::vector<int> targets = makeKeys(UNIFORM, n / 2);
+        timer.start();
+        BinaryHeap<int, 4, true> h;
+        for (int key : keys)
+            h.insert(key);
+        for (int target : targets)
+        {
+            int handle = static_cast<unsigned>(target) % n;
+            h.decreaseKey(handle, h.get(handle) / 2);
+        }
+        long sum = 0;
+        while (!h.empty())
+        {
+            sum += h.top();
+            h.pop();
+        }
+        timer.stop();
+        doNotOptimize(sum);
+    });
+
+    runner.run("std::priority_queue/decrease", n, [=](Timer &timer)
+    {
+        typedef std::pair<int, int> Entry;
+        std::vector<int> keys = makeKeys(UNIFORM, n);
+        std::vector<int> targets = makeKeys(UNIFORM, n / 2);
+        timer.start();
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> h;
+        std::vector<int> current = keys;
+        for (long i = 0; i < n; ++i)
+            h.push({keys[i], static_cast<int>(i)});
+        for (int target : targets)
+        {
+            int index = static_cast<unsigned>(target) % n;
+            current[index] /= 2;
+            h.push({current[index], index});
+        }
+        long sum = 0;
+        while (!h.empty())
+        {
+            Entry e = h.top();
+            h.pop();
+            if (e.first == current[e.second])
+            {
+                sum += e.first;
+                current[e.second] = -1;
+            }
+        }
+        timer.stop();
+        doNotOptimize(sum);
+    });
+}
+
+int main(int argc, char **argv)
+{
+    Runner runner{argc, argv};
+    benchHeap<BinaryHeap<int>>(runner, "BinaryHeap");
+    benchHeap<BinaryHeap<int, 4>>(runner, "BinaryHeap<4>");
+    benchHeap<BinaryHeap<int, 8>>(runner, "BinaryHeap<8>");
+    benchHeap<StdMinHeap>(runner, "std::priority_queue");
+    benchDecrease(runner);
+}
@@ -0,0 +1,143 @@
+#include <list>
+#include "Bench.h"
+#include "List/List.h"
+#include "List/UnrolledList.h"
+
+using namespace bench;
+
+template <typename ListType>
+void benchList(Runner &runner, const std::string &name)
+{
+    long n = runner.elements();
+
+    runner.run(name + "/push_back", n, [=](Timer &timer)
+    {
+        timer.start();
+        ListType l;
+        for (long i = 0; i < n; ++i)
+            l.push_back(static_cast<int>(i));
+        timer.stop();
+        doNotOptimize(l.back());
+    });
+
+    runner.run(name + "/push_front", n, [=](Timer &timer)
+    {
+        timer.start();
+        ListType l;
+        for (long i = 0; i < n; ++i)
+            l.push_front(static_cast<int>(i));
+        timer.stop();
+        doNotOptimize(l.front());
+    });
+
+    runner.run(name + "/iterate", n, [=](Timer &timer)
+    {
+        ListType l;
+        for (long i = 0; i < n; ++i)
+            l.push_back(static_cast<int>(i));
+
+        long sum = 0;
+        timer.start();
+        for (int x : l)
+            sum += x;
+        timer.stop();
+        doNotOptimize(sum);
+    });
+
+    // Inserts before positions reached by walking forward key % 16 nodes,
+    // so the walk order follows the distribution.
+    for (Distribution d : ALL_DISTRIBUTIONS)
+        runner.run(benchName(name, "insert", d), n, [=](Timer &timer)
+        {
+            std::vector<int> steps = makeKeys(d, n);
+            ListType l;
+            l.push_back(0);
+
+            timer.start();
+            auto itr = l.begin();
+            for (int step : steps)
+            {
+                for (int i = step % 16; i > 0; --i)
+                    if (++itr == l.end())
+                        itr = l.begin();
+                itr = l.insert(itr, step);
+            }
+            timer.stop();
+            doNotOptimize(l.size());
+        });
+
+    // Full traversals of a list built by the inserts above, whose nodes
+    // are no longer in address order unless the distribution is SORTED.
+    for (Distribution d : ALL_DISTRIBUTIONS)
+        runner.run(benchName(name, "scan", d), n, [=](Timer &timer)
+        {
+            std::vector<int> steps = makeKeys(d, n);
+            ListType l;
+            l.push_back(0);
+            auto itr = l.begin();
+            for (int step : steps)
+            {
+                for (int i = step % 16; i > 0; --i)
+                    if (++itr == l.end())
+                        itr = l.begin();
+                itr = l.insert(itr, step);
+            }
+
+            long sum = 0;
+            timer.start();
+            for (int x : l)
+                sum += x;
+            timer.stop();
+            doNotOptimize(sum);
+        });
+
+    runner.run(name + "/erase", n, [=](Timer &timer)
+    {
+        ListType l;
+        for (long i = 0; i < n; ++i)
+            l.push_back(static_cast<int>(i));
+
+        timer.start();
+        for (auto itr = l.begin(); itr != l.end(); )
+            itr = l.erase(itr);
+        timer.stop();
+        doNotOptimize(l.size());
+    });
+
+    // A queue at steady state: every push is matched by a pop.
+    runner.run(name + "/churn", n, [=](Timer &timer)
+    {
+        ListType l;
+        for (int i = 0; i < 1024; ++i)
+            l.push_back(i);
+
+        timer.start();
+        for (long i = 0; i < n; ++i)
+        {
+            l.push_back(static_cast<int>(i));
+            l.pop_front();
+        }
+        timer.stop();
+        doNotOptimize(l.front());
+    });
+
+    runner.run(name + "/clear", n, [=](Timer &timer)
+    {
+        ListType l;
+        for (long i = 0; i < n; ++i)
+            l.push_back(static_cast<int>(i));
+
+        timer.start();
+        l.clear();
+        timer.stop();
+        doNotOptimize(l.size());
+    });
+}
+
+int main(int argc, char **argv)
+{
+    Runner runner{argc, argv};
+    benchList<List<int>>(runner, "List");
+    benchList<UnrolledList<int>>(runner, "UnrolledList");
+    benchList<std::list<int>>(runner, "std::list");
+}
@@ -0,0 +1,86 @@
+#include <unordered_set>
+#include "MapBench.h"
+#include "SetBench.h"
+#include "QuadraticProbingHashingTable.h"
+
+using namespace bench;
+
+// The prime modulo the sizing policies replaced, as a baseline.
+class ModuloSizing
+{
+public:
+    enum {PROBE_INCREMENT = 2};
+
+    int resize(int n)
+    {
+        tableSize = nextPrime(n);
+        return tableSize;
+    }
+
+    size_t index(size_t hashVal) const
+    {
+        return hashVal % tableSize;
+    }
+
+private:
+    size_t tableSize;
+};
+
+// What each sizing policy costs a lookup: the reduction of a hash to an
+// index on its own, then hits and misses in a table of uniform keys.
+template <typename SizePolicy>
+void benchSizing(Runner &runner, const std::string &name)
+{
+    long n = runner.elements();
+
+    runner.run(name + "/index", n, [=](Timer &timer)
+    {
+        std::vector<int> keys = makeKeys(UNIFORM, n);
+        SizePolicy policy;
+        policy.resize(static_cast<int>(2 * n));
+
+        size_t sum = 0;
+        timer.start();
+        for (int key : keys)
+            sum += policy.index(std::hash<int>{}(key));
+        timer.stop();
+        doNotOptimize(sum);
+    });
+
+    for (bool hit : {true, false})
+        runner.run(name + (hit ? "/lookup_hit" : "/lookup_miss"), n, [=](Timer &timer)
+        {
+            std::vector<int> keys = makeKeys(UNIFORM, n);
+            std::vector<int> lookups = hit ? keys : missingKeys(n);
+            HashTable<int, SizePolicy> table;
+            for (int key : keys)
+                table.insert(key);
+            std::shuffle(lookups.begin(), lookups.end(), std::mt19937_64{99});
+
+            long found = 0;
+            timer.start();
+            for (int key : lookups)
+                found += table.contains(key);
+            timer.stop();
+            doNotOptimize(found);
+        });
+}
+
+int main(int argc, char **argv)
+{
+    Runner runner{argc, argv};
+    benchSizing<ModuloSizing>(runner, "Sizing<Modulo>");
+    benchSizing<PrimeSizing>(runner, "Sizing<Prime>");
+    benchSizing<FastRangeSizing>(runner, "Sizing<FastRange>");
+    benchSizing<PowerOfTwoSizing>(runner, "Sizing<PowerOfTwo>");
+    benchSet<HashTable<int>>(runner, "QuadraticProbing");
+    benchBatch<HashTable<int>>(runner, "QuadraticProbing");
+    benchTransparent<HashTable<std::string>>(runner, "QuadraticProbing<string>");
+    benchFindWithHash<HashTable<std::string>>(runner, "QuadraticProbing<string>");
+    benchSet<HashTable<int, FastRangeSizing>>(runner, "QuadraticProbing<FastRange>");
+    benchSet<HashTable<int, PowerOfTwoSizing>>(runner, "QuadraticProbing<PowerOfTwo>");
+    benchSet<std::unordered_set<int>>(runner, "std::unordered_set");
+    benchMap<HashMap<int, int>>(runner, "QuadraticProbingMap");
+    benchMap<std::unordered_map<int, int>>(runner, "std::unordered_map");
+    reportStats<HashTable<int, PrimeSizing, CountStats>>(runner.elements(), "QuadraticProbing");
+}
@@ -0,0 +1,129 @@
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include "Bench.h"
+#include "List/BoundedQueue.h"
+#include "List/List.h"
+#include "List/LockFreeQueue.h"
+
+using namespace bench;
+
+// The work queue the concurrent ones replace: a List behind a mutex.
+class MutexQueue
+{
+public:
+    bool tryPush(int x)
+    {
+        std::lock_guard<std::mutex> guard{lock};
+        items.push_back(x);
+        return true;
+    }
+
+    bool tryPop(int &x)
+    {
+        std::lock_guard<std::mutex> guard{lock};
+        if (items.empty())
+            return false;
+        x = items.front();
+        items.pop_front();
+        return true;
+    }
+
+private:
+    std::mutex lock;
+    List<int> items;
+};
+
+class UnboundedQueue
+{
+public:
+    bool tryPush(int x)
+    {
+        queue.push(x);
+        return true;
+    }
+
+    bool tryPop(int &x)
+    {
+        return queue.tryPop(x);
+    }
+
+private:
+    LockFreeQueue<int> queue;
+};
+
+class RingQueue
+{
+public:
+    RingQueue() : queue{CAPACITY}
+    {
+    }
+
+    bool tryPush(int x)
+    {
+        return queue.tryPush(x);
+    }
+
+    bool tryPop(int &x)
+    {
+        return queue.tryPop(x);
+    }
+
+private:
+    enum {CAPACITY = 1024};
+    BoundedQueue<int> queue;
+};
+
+// threads producers and as many consumers hand n items through one queue.
+// A thread that finds the queue full or empty yields and retries, so the
+// time covers contention as well as the handoffs themselves.
+template <typename Queue>
+void benchQueue(Runner &runner, const std::string &name)
+{
+    long n = runner.elements();
+
+    for (int threads : {1, 2, 4, 8})
+        runner.run(name + "/" + std::to_string(threads) + "x" + std::to_string(threads), n, [=](Timer &timer)
+        {
+            Queue queue;
+            std::atomic<long> popped{0};
+            std::atomic<long> sum{0};
+            std::vector<std::thread> workers;
+
+            timer.start();
+            for (int t = 0; t < threads; ++t)
+                workers.emplace_back([&, t]
+                {
+                    for (long i = t; i < n; i += threads)
+                        while (!queue.tryPush(static_cast<int>(i)))
+                            std::this_thread::yield();
+                });
+            for (int t = 0; t < threads; ++t)
+                workers.emplace_back([&]
+                {
+                    long local = 0;
+                    int x;
+                    while (popped.load(std::memory_order_relaxed) < n)
+                        if (queue.tryPop(x))
+                        {
+                            local += x;
+                            popped.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        else
+                            std::this_thread::yield();
+                    sum += local;
+                });
+            for (auto &worker : workers)
+                worker.join();
+            timer.stop();
+            doNotOptimize(sum.load());
+        });
+}
+
+int main(int argc, char **argv)
+{
+    Runner runner{argc, argv};
+    benchQueue<MutexQueue>(runner, "List+mutex");
+    benchQueue<UnboundedQueue>(runner, "LockFreeQueue");
+    benchQueue<RingQueue>(runner, "BoundedQueue");
+}
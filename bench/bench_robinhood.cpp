@@ -0,0 +1,65 @@
+#include <unordered_set>
+#include "SetBench.h"
+#include "RobinHoodHashingTable.h"
+
+using namespace bench;
+
+const int CHURN_ROUNDS = 10;
+
+// Length under which a fraction of the lookups counted in s fall.
+int percentile(const HashStats &s, double fraction)
+{
+    double seen = 0;
+    for (int length = 0; length < HashStats::HISTOGRAM_SIZE; ++length)
+        if ((seen += s.probeLengths[length]) >= fraction * s.size)
+            return length;
+    return HashStats::HISTOGRAM_SIZE - 1;
+}
+
+// Keeps a table at 85% load while each round removes a tenth of its keys
+// at random and inserts as many fresh ones, and prints the mean probe
+// length and its tail after every round. Robin Hood insertion and
+// backward-shift removal should keep them flat.
+void reportChurn(long n)
+{
+    typedef RobinHoodHashTable<int> Table;
+    Table table(static_cast<int>(n));
+    long live = table.capacity() * 85L / 100;
+    long churn = live / 10;
+
+    std::vector<int> pool = makeKeys(SORTED, live + CHURN_ROUNDS * churn);
+    std::mt19937_64 generator{42};
+    std::shuffle(pool.begin(), pool.end(), generator);
+    std::vector<int> present(pool.begin(), pool.begin() + live);
+    long next = live;
+    for (int key : present)
+        table.insert(key);
+
+    std::printf("\n%-48s %14s %14s %14s\n", "Probe lengths under churn", "mean", "p99", "p99.9");
+    for (int round = 0; round <= CHURN_ROUNDS; ++round)
+    {
+        if (round > 0)
+            for (long i = 0; i < churn; ++i)
+            {
+                int &victim = present[generator() % present.size()];
+                table.remove(victim);
+                victim = pool[next++];
+                table.insert(victim);
+            }
+
+        HashStats s = table.stats();
+        double total = 0;
+        for (int length = 0; length < HashStats::HISTOGRAM_SIZE; ++length)
+            total += static_cast<double>(length) * s.probeLengths[length];
+        std::printf("%-48s %14.2f %14d %14d\n", ("RobinHood/round" + std::to_string(round)).c_str(),
+                    total / s.size, percentile(s, 0.99), percentile(s, 0.999));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Runner runner{argc, argv};
+    benchSet<RobinHoodHashTable<int>>(runner, "RobinHood");
+    benchSet<std::unordered_set<int>>(runner, "std::unordered_set");
+    reportChurn(runner.elements());
+}
@@ -0,0 +1,145 @@
+#include <string>
+#include "Bench.h"
+#include "HashUtils.h"
+#include "StringHash.h"
+
+using namespace bench;
+
+// The multiply-by-37 hash of the textbook tables, which hashBytes replaced.
+struct Multiply37
+{
+    size_t operator()(const std::string &key) const
+    {
+        size_t hashVal = 0;
+        for (char ch : key)
+            hashVal = hashVal * 37 + ch;
+        return hashVal;
+    }
+};
+
+struct Wyhash
+{
+    size_t operator()(const std::string &key) const
+    {
+        return hashBytes(key.data(), key.size());
+    }
+};
+
+enum KeySet {SHORT, LONG, COLLIDING};
+
+const KeySet ALL_KEY_SETS[] = {SHORT, LONG, COLLIDING};
+
+inline const char *keySetName(KeySet set)
+{
+    switch (set)
+    {
+    case SHORT:
+        return "short";
+    case LONG:
+        return "long";
+    default:
+        return "adversarial";
+    }
+}
+
+// SHORT keys are identifiers of 5 to 14 bytes and LONG ones URLs of about
+// 80 bytes that differ only at the end. COLLIDING keys all hash alike
+// under Multiply37: each is 24 two-byte blocks, "Ab" or "B=", and
+// 'A' * 37 + 'b' == 'B' * 37 + '='.
+inline std::vector<std::string> makeStrings(KeySet set, long n)
+{
+    std::vector<int> keys = makeKeys(UNIFORM, n);
+    std::vector<std::string> strings(n);
+    for (long i = 0; i < n; ++i)
+        switch (set)
+        {
+        case SHORT:
+            strings[i] = "id" + std::to_string(keys[i] % 1000000007);
+            break;
+        case LONG:
+            strings[i] = "https://www.example.com/static/assets/images/thumbnails/" + std::to_string(keys[i]) + ".png";
+            break;
+        case COLLIDING:
+            for (int block = 0; block < 24; ++block)
+                strings[i] += (i >> block) & 1 ? "B=" : "Ab";
+            break;
+        }
+    return strings;
+}
+
+// Times hashing every key; an operation is one byte, so ns/op is the
+// inverse of the throughput.
+template <typename Hash>
+void benchThroughput(Runner &runner, const std::string &name)
+{
+    long n = runner.elements();
+
+    for (KeySet set : ALL_KEY_SETS)
+    {
+        std::vector<std::string> strings = makeStrings(set, n);
+        long bytes = 0;
+        for (auto &s : strings)
+            bytes += s.size();
+
+        runner.run(name + "/bytes/" + keySetName(set), bytes, [&](Timer &timer)
+        {
+            size_t sum = 0;
+            timer.start();
+            for (auto &s : strings)
+                sum += Hash{}(s);
+            timer.stop();
+            doNotOptimize(sum);
+        });
+    }
+}
+
+// Keys that land in an already used bucket of a table of strings.size()
+// buckets indexed by SizePolicy.
+template <typename Hash, typename SizePolicy>
+long bucketCollisions(const std::vector<std::string> &strings)
+{
+    SizePolicy sizer;
+    std::vector<bool> used(sizer.resize(static_cast<int>(strings.size())));
+    long collisions = 0;
+    for (auto &s : strings)
+    {
+        size_t bucket = sizer.index(Hash{}(s));
+        collisions += used[bucket];
+        used[bucket] = true;
+    }
+    return collisions;
+}
+
+// What a random hash would give for n keys in buckets buckets.
+inline double expectedCollisions(long n, long buckets)
+{
+    return n - buckets * (1 - std::pow(1 - 1.0 / buckets, static_cast<double>(n)));
+}
+
+template <typename Hash>
+void reportCollisions(long n, const std::string &name)
+{
+    for (KeySet set : ALL_KEY_SETS)
+    {
+        std::vector<std::string> strings = makeStrings(set, n);
+        std::printf("%-48s %14ld %14ld\n", (name + "/" + keySetName(set)).c_str(),
+                    bucketCollisions<Hash, PowerOfTwoSizing>(strings),
+                    bucketCollisions<Hash, PrimeSizing>(strings));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Runner runner{argc, argv};
+    benchThroughput<Wyhash>(runner, "wyhash");
+    benchThroughput<Multiply37>(runner, "multiply37");
+
+    long n = runner.elements();
+    PowerOfTwoSizing powerOfTwo;
+    PrimeSizing prime;
+    std::printf("\n%-48s %14s %14s\n", "Bucket collisions", "PowerOfTwo", "Prime");
+    std::printf("%-48s %14.0f %14.0f\n", "random (expected)",
+                expectedCollisions(n, powerOfTwo.resize(n)), expectedCollisions(n, prime.resize(n)));
+    reportCollisions<Wyhash>(n, "wyhash");
+    reportCollisions<Multiply37>(n, "multiply37");
+}
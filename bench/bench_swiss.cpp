@@ -0,0 +1,12 @@
+#include <unordered_set>
+#include "SetBench.h"
+#include "SwissHashTable.h"
+
+using namespace bench;
+
+int main(int argc, char **argv)
+{
+    Runner runner{argc, argv};
+    benchSet<SwissHashTable<int>>(runner, "Swiss");
+    benchSet<std::unordered_set<int>>(runner, "std::unordered_set");
+}
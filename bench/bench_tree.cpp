@@ -0,0 +1,18 @@
+#include <set>
+#include "SetBench.h"
+#include "Tree/AVLTree.h"
+#include "Tree/BinarySearchTree.h"
+
+using namespace bench;
+
+// Sorted input turns BinarySearchTree into a list, with quadratic build
+// time and recursion as deep as the element count.
+const long MAX_UNBALANCED = 20000;
+
+int main(int argc, char **argv)
+{
+    Runner runner{argc, argv};
+    benchSet<BinarySearchTree<int>>(runner, "BinarySearchTree", MAX_UNBALANCED);
+    benchSet<AVLTree<int>>(runner, "AVLTree");
+    benchSet<std::set<int>>(runner, "std::set");
+}
@@ -0,0 +1,75 @@
+#include <vector>
+#include "Bench.h"
+#include "Vector/Vector.h"
+
+using namespace bench;
+
+template <typename Vec>
+void benchVector(Runner &runner, const std::string &name)
+{
+    long n = runner.elements();
+
+    runner.run(name + "/push_back", n, [=](Timer &timer)
+    {
+        timer.start();
+        Vec v;
+        for (long i = 0; i < n; ++i)
+            v.push_back(static_cast<int>(i));
+        timer.stop();
+        doNotOptimize(v[n - 1]);
+    });
+
+    // Reads at key % n, so SORTED is a sequential scan and the others
+    // gather from scattered positions.
+    for (Distribution d : ALL_DISTRIBUTIONS)
+        runner.run(benchName(name, "read", d), n, [=](Timer &timer)
+        {
+            std::vector<int> indices = makeKeys(d, n);
+            for (auto &index : indices)
+                index %= n;
+            Vec v;
+            for (long i = 0; i < n; ++i)
+                v.push_back(static_cast<int>(i));
+
+            long sum = 0;
+            timer.start();
+            for (int index : indices)
+                sum += v[index];
+            timer.stop();
+            doNotOptimize(sum);
+        });
+}
+
+// Builds and sums many vectors of TINY elements each, where the cost is
+// mostly in allocating them.
+template <typename Vec>
+void benchTiny(Runner &runner, const std::string &name)
+{
+    const int TINY = 4;
+    long n = runner.elements();
+
+    runner.run(name + "/tiny", n, [=](Timer &timer)
+    {
+        std::vector<Vec> vectors(n / TINY);
+        long sum = 0;
+        timer.start();
+        for (auto &v : vectors)
+            for (int i = 0; i < TINY; ++i)
+                v.push_back(i);
+        for (auto &v : vectors)
+            for (int x : v)
+                sum += x;
+        timer.stop();
+        doNotOptimize(sum);
+    });
+}
+
+int main(int argc, char **argv)
+{
+    Runner runner{argc, argv};
+    benchVector<Vector<int>>(runner, "Vector");
+    benchVector<std::vector<int>>(runner, "std::vector");
+    benchTiny<Vector<int>>(runner, "Vector");
+    benchTiny<SmallVector<int, 4>>(runner, "SmallVector");
+    benchTiny<std::vector<int>>(runner, "std::vector");
+}